@@ -15,9 +15,14 @@ QDaqChannel::QDaqChannel(const QString& name) :
     digits_(6),
     v_(0.), dv_(0.),
     offset_(0.), multiplier_(1.),
+    x_(0.),
     parser_(0),
+    newParserInputs_(0),
     dataReady_(false),
-    counter_(0)
+    counter_(0),
+    lastCounter_(0),
+    dirty_(true),
+    clockLoop_(0)
 {
     range_ << -1e30 << 1.e30;
     ff_ = 0.;
@@ -57,6 +62,7 @@ void QDaqChannel::setType(ChannelType t)
     }
     if (channeltype_ != t)
     {
+        if (stageProperty("type",QVariant::fromValue(t))) return;
         {
             os::auto_lock L(comm_lock);
             channeltype_ = t;
@@ -82,21 +88,27 @@ void QDaqChannel::setRange(const QDaqVector &v)
 		// fix ordering
         QDaqVector myv ( v );
 		if (v[1]<v[0]) { myv[0] = v[1]; myv[1] = v[0]; }
+		if (stageProperty("range",QVariant::fromValue(myv))) return;
 		// set the range
         os::auto_lock L(comm_lock);
 		range_ = myv;
+		dirty_ = true;
 		emit propertiesChanged();
 	}
 }
 void QDaqChannel::setOffset(double v)
 {
+    if (stageProperty("offset",v)) return;
     os::auto_lock L(comm_lock);
 	offset_ = v;
+	dirty_ = true;
 }
 void QDaqChannel::setMultiplier(double v)
 {
+    if (stageProperty("multiplier",v)) return;
     os::auto_lock L(comm_lock);
 	multiplier_ = v;
+	dirty_ = true;
 }
 void QDaqChannel::setAveraging(AveragingType t)
 {
@@ -112,9 +124,11 @@ void QDaqChannel::setAveraging(AveragingType t)
 	}
 	if (type_ != t)
 	{
+		if (stageProperty("averaging",QVariant::fromValue(t))) return;
 		{
             os::auto_lock L(comm_lock);
 			type_ = t;
+			dirty_ = true;
 		}
 		emit propertiesChanged();
 	}
@@ -123,21 +137,114 @@ void QDaqChannel::setDepth(uint d)
 {
 	if ((d!=depth_) && d>0)
 	{
+		if (stageProperty("depth",d)) return;
 		{
             os::auto_lock L(comm_lock);
 			depth_ = d;
 			buff_.alloc(d);
 			ffw_ = 1. / (1. - pow(ff_,(int)d));
+			dirty_ = true;
 		}
 		emit propertiesChanged();
 	}
 }
 bool QDaqChannel::arm_()
 {
-	counter_ = 0;
+	counter_ = lastCounter_ = 0;
 	dataReady_ = false;
+	dirty_ = true;
+    clockLoop_ = topLoop();
+    if (!bindParserInputs()) return false;
     return QDaqJob::arm_();
 }
+// allow channel paths (qdaq.loop.ch) as variable names
+static void defineNameChars(mu::Parser* p)
+{
+    p->DefineNameChars("0123456789_."
+                       "abcdefghijklmnopqrstuvwxyz"
+                       "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+}
+bool QDaqChannel::findParserInputs(const QString& s, QVector< QPointer<QDaqChannel> >& inputs)
+{
+    inputs.clear();
+    if (s.isEmpty()) return true;
+
+    try
+    {
+        mu::Parser p;
+        defineNameChars(&p);
+        p.DefineVar("x",&x_);
+        p.SetExpr(s.toStdString());
+        mu::varmap_type vars = p.GetUsedVar();
+        for(mu::varmap_type::const_iterator it = vars.begin(); it!=vars.end(); ++it)
+        {
+            if (it->first == "x") continue;
+
+            QString name(it->first.c_str());
+            QDaqChannel* ch = qobject_cast<QDaqChannel*>(findByName(name));
+            if (!ch)
+            {
+                throwScriptError(QString("muParser variable %1 is not a channel.").arg(name));
+                return false;
+            }
+            if (ch!=this) inputs.push_back(ch);
+        }
+    }
+    catch (mu::Parser::exception_type &e)
+    {
+        throwScriptError(QString("muParser: %1").arg(e.GetMsg().c_str()));
+        return false;
+    }
+    return true;
+}
+bool QDaqChannel::bindParserInputs()
+{
+    parserInputs_.clear();
+    if (!parser_) return true;
+
+    try
+    {
+        parser_->ClearVar();
+        parser_->DefineVar("x",&x_);
+
+        // GetUsedVar() returns also the variables not defined yet
+        mu::varmap_type vars = parser_->GetUsedVar();
+        for(mu::varmap_type::const_iterator it = vars.begin(); it!=vars.end(); ++it)
+        {
+            if (it->first == "x") continue;
+
+            QString name(it->first.c_str());
+            QDaqChannel* ch = qobject_cast<QDaqChannel*>(findByName(name));
+            if (!ch)
+            {
+                throwScriptError(QString("muParser variable %1 is not a channel.").arg(name));
+                return false;
+            }
+            parser_->DefineVar(it->first,&(ch->v_));
+            if (ch!=this) parserInputs_.push_back(ch);
+        }
+        parserInputUpdates_.fill(0,parserInputs_.size());
+    }
+    catch (mu::Parser::exception_type &e)
+    {
+        throwScriptError(QString("muParser: %1").arg(e.GetMsg().c_str()));
+        return false;
+    }
+    return true;
+}
+void QDaqChannel::dependencies(QList<QDaqJob*>& lst) const
+{
+    const QVector< QPointer<QDaqChannel> >& in = newParserInputs_ ? *newParserInputs_ : parserInputs_;
+    for(int i=0; i<in.size(); ++i)
+        if (in[i]) lst << in[i].data();
+}
+bool QDaqChannel::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    writes << this;
+    for(int i=0; i<parserInputs_.size(); ++i)
+        if (parserInputs_[i]) reads << parserInputs_[i].data();
+    return QDaqJob::dataAccess(reads,writes);
+}
 bool QDaqChannel::average()
 {
     int m = (counter_ < depth_) ? counter_ : depth_;
@@ -204,15 +311,32 @@ bool QDaqChannel::average()
 	return true;
 }
 
+bool QDaqChannel::hasChanged()
+{
+    bool changed = dirty_ || (counter_ != lastCounter_);
+    dirty_ = false;
+    lastCounter_ = counter_;
+    for(int i=0; i<parserInputs_.size(); ++i)
+    {
+        QDaqChannel* ch = parserInputs_[i];
+        if (!ch) changed = true; // report the lost channel
+        else if (ch->nComputed_ != parserInputUpdates_[i])
+        {
+            parserInputUpdates_[i] = ch->nComputed_;
+            changed = true;
+        }
+    }
+    return changed;
+}
 bool QDaqChannel::run()
 {
     if (!QDaqJob::run()) return false;
 
-    dataReady_ = true;
     switch (channeltype_)
     {
     case Clock:
-        push(QDaqTimeValue::now());
+        // the virtual clock when replaying
+        push(clockLoop_ ? clockLoop_->clockTime() : QDaqTimeValue::now());
         break;
     case Random:
         push(1.*rand()/RAND_MAX);
@@ -228,10 +352,31 @@ bool QDaqChannel::run()
         break;
     }
 
-    if ((dataReady_=average()))
+    if (!hasChanged())
+    {
+        nSkipped_++;
+        return true;
+    }
+    nComputed_++;
+
+    // channels referencing other channels in their parser expression
+    // are evaluated even without new data.
+    // x keeps the last average, v_ holds the scaled value of the previous cycle.
+    bool fresh = average();
+    if (fresh) x_ = v_;
+    if ((dataReady_ = (fresh || !parserInputs_.isEmpty())))
 	{
 		if (parser_)
 		{
+			for(int i=0; i<parserInputs_.size(); ++i)
+			{
+				if (!parserInputs_[i])
+				{
+					pushError("Parser input channel lost.");
+					return false;
+				}
+			}
+
 			try
 			{
 			  v_ = parser_->Eval();
@@ -246,18 +391,20 @@ bool QDaqChannel::run()
 			}
 		}
 
+		if (dataReady_)
 		{
 			v_ = multiplier_*v_ + offset_;
-			dv_ = multiplier_*dv_ + offset_;
-		}
+			// the std of the last average
+			if (fresh) dv_ = multiplier_*dv_ + offset_;
 
-        // handle over/under flow
-        if (v_ < range_[0]) v_ = range_[0];
-        if (v_ > range_[1]) v_ = range_[1];
+			// handle over/under flow
+			if (v_ < range_[0]) v_ = range_[0];
+			if (v_ > range_[1]) v_ = range_[1];
 
-        dataReady_ = std::isfinite(v_);
+			dataReady_ = std::isfinite(v_);
+		}
 
-        emit updateWidgets();
+        notifyGui(WidgetsUpdate);
 	}
 
     return true;
@@ -284,9 +431,11 @@ QString QDaqChannel::formatedValue()
 
 void QDaqChannel::clear()
 {
+    if (stageCall("clear")) return;
     os::auto_lock L(comm_lock);
 	counter_ = 0;
 	dataReady_ = false;
+	dirty_ = true;
 }
 
 
@@ -299,9 +448,11 @@ void QDaqChannel::setForgettingFactor(double v)
 {
 	if (v!=ff_ && v>0. && v<1.)
 	{
+		if (stageProperty("forgettingFactor",v)) return;
         os::auto_lock L(comm_lock);
 		ff_ = v;
 		ffw_ = 1./(1. - pow(ff_,(int)depth_));
+		dirty_ = true;
 		emit propertiesChanged();
 	}
 }
@@ -309,30 +460,73 @@ void QDaqChannel::setParserExpression(const QString& s)
 {
 	if (s!=parserExpression())
 	{
-        os::auto_lock L(comm_lock);
+        if (armed_)
+        {
+            // check the new expression before it reaches the loop:
+            // its variables must be channels and must not create a cycle
+            QVector< QPointer<QDaqChannel> > inputs;
+            if (!findParserInputs(s,inputs)) return;
+            QString cycle;
+            newParserInputs_ = &inputs;
+            bool ok = sortParents(cycle,false);
+            newParserInputs_ = 0;
+            if (!ok)
+            {
+                throwScriptError(QString("Circular dependency between jobs: %1").arg(cycle));
+                return;
+            }
 
-		if (s.isEmpty())
-		{
-			if (parser_) delete parser_;
-			parser_ = 0;
-		}
-		else
-		{
-			if (!parser_)
-			{
-				parser_= new mu::Parser();
-				parser_->DefineVar("x",&v_);
-			}
-			parser_->SetExpr(s.toStdString());
-		}
+            // re-bind the channel references and put the new inputs before
+            // this channel here, with the loop between cycles, so that the
+            // job lists are not changed under readers of this thread
+            LoopPause P(this);
+            os::auto_lock L(comm_lock);
+            QString old = parserExpression();
+            setParser(s);
+            if (!bindParserInputs())
+            {
+                setParser(old);
+                bindParserInputs();
+                return;
+            }
+            sortParents(cycle,true);
+            invalidateSchedule();
+            dirty_ = true;
+        }
+        else
+        {
+            if (stageProperty("parserExpression",s)) return;
+            os::auto_lock L(comm_lock);
+            setParser(s);
+            dirty_ = true;
+        }
 
 		emit propertiesChanged();
 	}
 }
+void QDaqChannel::setParser(const QString& s)
+{
+    if (s.isEmpty())
+    {
+        if (parser_) delete parser_;
+        parser_ = 0;
+    }
+    else
+    {
+        if (!parser_)
+        {
+            parser_= new mu::Parser();
+            defineNameChars(parser_);
+            parser_->DefineVar("x",&x_);
+        }
+        parser_->SetExpr(s.toStdString());
+    }
+}
 
 
 //////////////////// QDaqFilterChannel /////////////////////////////
-QDaqFilterChannel::QDaqFilterChannel(const QString& name) : QDaqChannel(name)
+QDaqFilterChannel::QDaqFilterChannel(const QString& name) : QDaqChannel(name),
+    skipUnchanged_(false), inputUpdates_(0), inputReady_(true)
 {
 }
 void QDaqFilterChannel::setInputChannel(QDaqObject* obj)
@@ -340,8 +534,22 @@ void QDaqFilterChannel::setInputChannel(QDaqObject* obj)
     QDaqChannel* ch = qobject_cast<QDaqChannel*>(obj);
     if (ch)
     {
+        if (stageProperty("inputChannel",QVariant::fromValue(obj))) return;
         os::auto_lock L(comm_lock);
         inputChannel_ = ch;
+        if (armed_) invalidateSchedule();
+        emit propertiesChanged();
+    }
+}
+void QDaqFilterChannel::setSkipUnchanged(bool on)
+{
+    if (skipUnchanged_ != on)
+    {
+        if (stageProperty("skipUnchanged",on)) return;
+        {
+            os::auto_lock L(comm_lock);
+            skipUnchanged_ = on;
+        }
         emit propertiesChanged();
     }
 }
@@ -351,10 +559,33 @@ QDaqObject* QDaqFilterChannel::inputChannel()
     else if (qobject_cast<QDaqChannel*>(parent())) return (QDaqObject*)parent();
     else return 0;
 }
+bool QDaqFilterChannel::arm_()
+{
+    inputUpdates_ = 0;
+    inputReady_ = true;
+    return QDaqChannel::arm_();
+}
+bool QDaqFilterChannel::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    if (inputChannel_) reads << inputChannel_.data();
+    else if (qobject_cast<QDaqChannel*>(parent())) reads << (QDaqObject*)parent();
+    return QDaqChannel::dataAccess(reads,writes);
+}
 bool QDaqFilterChannel::run()
 {
     QDaqChannel* ch = (QDaqChannel*)inputChannel();
-    if (ch && ch->dataReady()) push(ch->value());
-    else push(0);
+    bool ready = ch && ch->dataReady();
+    if (ready)
+    {
+        // optionally push only values not seen before
+        if (!skipUnchanged_ || ch->updateCount() != inputUpdates_)
+        {
+            inputUpdates_ = ch->updateCount();
+            push(ch->value());
+        }
+    }
+    // an input that stays not ready is pushed once
+    else if (!skipUnchanged_ || inputReady_) push(0);
+    inputReady_ = ready;
     return QDaqChannel::run();
 }
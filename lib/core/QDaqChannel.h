@@ -83,6 +83,13 @@ class QDAQ_EXPORT QDaqChannel : public QDaqJob
 	/** muParser Expression.
 	If set the expression is executed on the channel data.
 	Note that the data goes first through muParser and then they are scaled with multiplier and offset.
+
+	In the expression, x denotes the averaged channel value. Other channels may
+	be referenced by their path in the QDaq tree, e.g. "x - qdaq.loop.t0".
+	These references are resolved when the channel is armed and the parent job
+	then executes the referenced channels before this one.
+	Such a channel is evaluated at each repetition, even if no data are pushed into it;
+	x is then the last average.
 	*/
 	Q_PROPERTY(QString parserExpression READ parserExpression WRITE setParserExpression)
 
@@ -126,11 +133,23 @@ protected:
     NumberFormat fmt_;
     int digits_;
 	double v_, dv_, offset_, multiplier_;
+    // last average, the variable x of the parser expression
+    double x_;
     mu::Parser* parser_;
+    // channels referenced in the parser expression
+    QVector< QPointer<QDaqChannel> > parserInputs_;
+    // updateCount() of parser inputs when last computed
+    QVector<uint> parserInputUpdates_;
     bool dataReady_;
     QDaqVector range_;
     // a counter incremented at each new value
     uint counter_;
+    // counter_ value when last computed
+    uint lastCounter_;
+    // set when a property affecting the channel value changes
+    bool dirty_;
+    // top loop providing the time of Clock channels
+    QDaqLoop* clockLoop_;
 	uint depth_;
 	double ff_, ffw_;
 
@@ -139,6 +158,21 @@ protected:
 
 	virtual bool arm_();
 
+    // parser input channels must run before this one
+    virtual void dependencies(QList<QDaqJob*>& lst) const;
+
+    // writes the channel, reads the parser input channels
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
+
+    // resolve channel references in the parser expression
+    bool bindParserInputs();
+    // set the expression of the parser, creating or deleting it
+    void setParser(const QString& s);
+    // channels referenced in expression s, or false if some is not a channel
+    bool findParserInputs(const QString& s, QVector< QPointer<QDaqChannel> >& inputs);
+    // inputs of a new expression, used by dependencies() while it is checked
+    const QVector< QPointer<QDaqChannel> >* newParserInputs_;
+
     /**
      * @brief Perform channel tasks.
      *
@@ -151,7 +185,11 @@ protected:
      *   - the mean value is scaled and shifted (multiplier*v + offset)
      *   - the mean value is checked for under/over range
      *
-     * If new data is available the updateWidgets signal is emitted.
+     * If no new data were pushed, no parser input channel was updated
+     * and no relevant property changed since the last call, the computation
+     * is skipped.
+     *
+     * If new data is available an updateWidgets signal is requested (see notifyGui()).
      *
      * @return always return true.
      */
@@ -162,6 +200,10 @@ protected:
 	// do the averaging operations in the channel
 	bool average();
 
+	// true if there is new data, new parser input or changed settings
+	// since the channel was last computed
+	bool hasChanged();
+
 public:
     Q_INVOKABLE explicit QDaqChannel(const QString& name);
     virtual ~QDaqChannel(void);
@@ -203,6 +245,16 @@ public:
 
 	double last() const { return buff_.last(); }
 
+	/// Number of times the channel value was computed since arming.
+	/// Jobs reading the channel may compare it to detect new values.
+	uint updateCount() const { return nComputed_; }
+
+	/// Number of values pushed since the channel was armed or cleared.
+	uint pushCount() const { return counter_; }
+	/// The i-th most recently pushed value, before averaging and scaling (0 is the last one).
+	/// Only the last memsize() values are kept.
+	double pushed(uint i) const { return buff_[i]; }
+
     /// Returns the channel value formatted according to format/digits
 	virtual QString formatedValue();
 
@@ -236,17 +288,36 @@ class QDAQ_EXPORT QDaqFilterChannel : public QDaqChannel
     /** The input channel to filter.
       */
     Q_PROPERTY(QDaqObject* inputChannel READ inputChannel WRITE setInputChannel)
+    /** Push only new values of the input channel.
+     *
+     * If true, the input value is pushed only when the input channel has been
+     * updated since the last cycle, otherwise the channel computation is skipped.
+     * While the input is not ready, 0 is pushed once and then skipped as well.
+     *
+     * Default is false, where the input is pushed every cycle, so that averaging
+     * is over depth loop cycles. If true, it is over depth input updates.
+     */
+    Q_PROPERTY(bool skipUnchanged READ skipUnchanged WRITE setSkipUnchanged)
 
 protected:
     QPointer<QDaqChannel> inputChannel_;
+    bool skipUnchanged_;
+    // updateCount() of the input when last pushed
+    uint inputUpdates_;
+    // the input was ready in the last cycle
+    bool inputReady_;
 
+    virtual bool arm_();
     virtual bool run();
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
 
 public:
-    QDaqFilterChannel(const QString& name);
+    Q_INVOKABLE explicit QDaqFilterChannel(const QString& name);
 
     void setInputChannel(QDaqObject* obj);
     QDaqObject* inputChannel();
+    bool skipUnchanged() const { return skipUnchanged_; }
+    void setSkipUnchanged(bool on);
 
 };
 #endif // QDAQDATACHANNEL_H
@@ -28,6 +28,8 @@ void QDaqDataBuffer::setBackBufferDepth(uint d)
 {
     if (d>0)
 	{
+        if (stageProperty("backBufferDepth",d)) return;
+
         os::auto_lock L(comm_lock);
 
         // depth should be power of 2
@@ -81,6 +83,8 @@ void QDaqDataBuffer::setChannels(QDaqObjectList chlist)
 		}
 	}
 
+    if (stageProperty("channels",QVariant::fromValue(chlist))) return;
+
     os::auto_lock L(comm_lock);
 
 	// clear previous channels
@@ -116,6 +120,8 @@ void QDaqDataBuffer::setChannels(QDaqObjectList chlist)
         setProperty(str.toLatin1(),v);
     }
 
+    if (armed_) invalidateSchedule();
+
     emit propertiesChanged();
 
 }
@@ -151,6 +157,13 @@ bool QDaqDataBuffer::run()
 
     return QDaqJob::run();
 }
+bool QDaqDataBuffer::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    writes << this;
+    for(int i=0; i<channel_ptrs.size(); i++)
+        if (channel_ptrs[i]) reads << channel_ptrs[i].data();
+    return QDaqJob::dataAccess(reads,writes);
+}
 void QDaqDataBuffer::onDataReady()
 {
     // get real-time data in
@@ -181,8 +194,7 @@ void QDaqDataBuffer::onDataReady()
     if (nread) {
         uint c = data_matrix[0].capacity();
         if (c!=capacity_) capacity_ = c;
-        emit updateWidgets();
-        emit propertiesChanged();
+        notifyGui(WidgetsUpdate | PropertiesChanged);
     }
 
 }
@@ -221,6 +233,20 @@ void QDaqDataBuffer::clear()
     emit updateWidgets();
 
 }
+void QDaqDataBuffer::pushColumns(const double* const* cols, int n)
+{
+    if (n<=0 || data_matrix.isEmpty()) return;
+
+    os::auto_lock L(comm_lock);
+
+    for(int j=0; j<data_matrix.size(); j++)
+        data_matrix[j].push(cols[j],n);
+
+    uint c = data_matrix[0].capacity();
+    if (c!=capacity_) capacity_ = c;
+
+    notifyGui(WidgetsUpdate | PropertiesChanged);
+}
 void QDaqDataBuffer::push(const QDaqVector &v)
 {
     os::auto_lock L(comm_lock);
@@ -233,8 +259,7 @@ void QDaqDataBuffer::push(const QDaqVector &v)
     uint c = data_matrix[0].capacity();
     if (c!=capacity_) capacity_ = c;
 
-    emit updateWidgets();
-    emit propertiesChanged();
+    notifyGui(WidgetsUpdate | PropertiesChanged);
 }
 
 
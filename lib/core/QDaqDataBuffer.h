@@ -109,6 +109,9 @@ protected:
      */
     virtual bool run();
 
+    // reads the channels, writes the buffer
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
+
     //void resize();
 
 public:
@@ -129,6 +132,14 @@ public:
 	void setType(BufferType t);
     void setChannels(QDaqObjectList chlist);
 
+    /**
+     * @brief Append n rows given column-wise.
+     *
+     * cols[j] points to n values of column j; there must be columns() of them.
+     * Used for writing blocks of data, e.g. by QDaqFilter::processBuffer().
+     */
+    void pushColumns(const double* const* cols, int n);
+
 signals:
     // emitted when a data packet becomes available
     void dataReady();
@@ -0,0 +1,134 @@
+#include "QDaqDataPlayer.h"
+#include "QDaqDataBuffer.h"
+#include "QDaqChannel.h"
+
+QDaqDataPlayer::QDaqDataPlayer(const QString& name) : QDaqJob(name),
+    repeat_(false), position_(0), rows_(0)
+{
+
+}
+
+// getters
+QDaqObject* QDaqDataPlayer::source() const
+{
+    return source_;
+}
+QDaqObjectList QDaqDataPlayer::channels() const
+{
+    QDaqObjectList lst;
+    for(int i=0; i<channels_.size(); i++)
+        lst.append(channels_[i]);
+    return lst;
+}
+
+// setters
+void QDaqDataPlayer::setSource(QDaqObject* obj)
+{
+    if (throwIfArmed()) return;
+    QDaqDataBuffer* buff = qobject_cast<QDaqDataBuffer*>(obj);
+    if (obj && !buff)
+    {
+        throwScriptError(QString("%1 is not a QDaqDataBuffer.").arg(obj->objectName()));
+        return;
+    }
+    source_ = buff;
+    emit propertiesChanged();
+}
+void QDaqDataPlayer::setChannels(QDaqObjectList lst)
+{
+    // check if we have valid QDaqChannels
+    for(int i=0; i<lst.size(); i++)
+    {
+        QDaqChannel* ch = qobject_cast<QDaqChannel*>(lst.at(i));
+        if (!ch)
+        {
+            throwScriptError(QString("%1 is not a channel.").arg(lst.at(i)->objectName()));
+            return;
+        }
+    }
+    if (armed_ && lst.size() != columns_.size())
+    {
+        throwScriptError(QString("The number of channels must be equal to the source columns (%1).").arg(columns_.size()));
+        return;
+    }
+
+    if (stageProperty("channels",QVariant::fromValue(lst))) return;
+
+    channels_.clear();
+    for(int i=0; i<lst.size(); i++)
+        channels_.push_back(qobject_cast<QDaqChannel*>(lst.at(i)));
+    if (armed_) invalidateSchedule();
+    emit propertiesChanged();
+}
+void QDaqDataPlayer::setRepeat(bool on)
+{
+    if (repeat_ != on)
+    {
+        if (stageProperty("repeat",on)) return;
+        repeat_ = on;
+        emit propertiesChanged();
+    }
+}
+
+bool QDaqDataPlayer::arm_()
+{
+    if (!source_)
+    {
+        throwScriptError("No source data buffer.");
+        return false;
+    }
+    int n = source_->columns();
+    if (channels_.size() != n)
+    {
+        throwScriptError(QString("The number of channels must be equal to the source columns (%1).").arg(n));
+        return false;
+    }
+
+    columns_.resize(n);
+    rows_ = n ? source_->size() : 0;
+    for(int i=0; i<n; ++i)
+    {
+        columns_[i] = source_->get(i);
+        if (columns_[i].size() < rows_) rows_ = columns_[i].size();
+    }
+    position_ = 0;
+
+    return QDaqJob::arm_();
+}
+
+void QDaqDataPlayer::disarm_()
+{
+    columns_.clear();
+    QDaqJob::disarm_();
+}
+
+bool QDaqDataPlayer::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    writes << this;
+    for(int i=0; i<channels_.size(); i++)
+        if (channels_[i]) writes << channels_[i].data();
+    return QDaqJob::dataAccess(reads,writes);
+}
+
+bool QDaqDataPlayer::run()
+{
+    if ((int)position_ >= rows_)
+    {
+        if (!repeat_ || !rows_) return false; // end of data, the loop stops
+        position_ = 0;
+    }
+
+    for(int i=0; i<channels_.size(); i++)
+    {
+        QDaqChannel* ch = channels_[i];
+        if (!ch)
+        {
+            pushError("Output channel lost.");
+            return false;
+        }
+        ch->push(columns_.at(i)[position_]);
+    }
+    position_++;
+
+    return QDaqJob::run();
+}
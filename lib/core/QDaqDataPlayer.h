@@ -0,0 +1,95 @@
+#ifndef QDAQDATAPLAYER_H
+#define QDAQDATAPLAYER_H
+
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+
+#include <QPointer>
+
+class QDaqChannel;
+class QDaqDataBuffer;
+
+/**
+ * @brief A job that plays back recorded data into channels.
+ *
+ * @ingroup Core
+ * @ingroup ScriptAPI
+ *
+ * At each loop repetition QDaqDataPlayer pushes the next row of the
+ * source QDaqDataBuffer to the channels, column i going to channel i.
+ * The source may be a buffer recorded by a loop or read from an HDF5 file
+ * with h5read().
+ *
+ * Together with a loop running on a virtual clock (see QDaqLoop::virtualClock)
+ * it is used to process recorded data through the same job tree
+ * that acquired them, faster than real time:
+ * \code
+ * var rec = h5read("run.h5");
+ * var player = new QDaqDataPlayer("player");
+ * player.source = rec;
+ * player.channels = [loop.T, loop.P];
+ * loop.insertBefore(player, loop.T);
+ * loop.virtualClock = true;
+ * loop.period = 100; // the rate of the recording
+ * loop.arm();
+ * \endcode
+ *
+ * When the data end the job returns false and the loop aborts,
+ * unless repeat is true.
+ *
+ * The source data are copied (shallow copy) when the player is armed,
+ * so later changes of the source buffer have no effect on the playback.
+ *
+ */
+class QDAQ_EXPORT QDaqDataPlayer : public QDaqJob
+{
+    Q_OBJECT
+
+    /// The QDaqDataBuffer with the recorded data.
+    Q_PROPERTY(QDaqObject* source READ source WRITE setSource)
+    /** The channels that receive the data, one per source column.
+     *
+     * It can be changed while armed, keeping the number of channels;
+     * the change is applied between loop cycles.
+     */
+    Q_PROPERTY(QDaqObjectList channels READ channels WRITE setChannels)
+    /// The row that will be played next (read-only). It is reset to 0 when armed.
+    Q_PROPERTY(uint position READ position)
+    /// Start again from the first row when the data end. Default is false.
+    Q_PROPERTY(bool repeat READ repeat WRITE setRepeat)
+
+protected:
+    typedef QPointer<QDaqChannel> channel_t;
+    typedef QVector<channel_t> channel_vector_t;
+
+    QPointer<QDaqDataBuffer> source_;
+    channel_vector_t channels_;
+    bool repeat_;
+    uint position_;
+
+    // source columns, copied when armed
+    QVector<QDaqBuffer> columns_;
+    int rows_;
+
+    virtual bool arm_();
+    virtual void disarm_();
+    virtual bool run();
+    // writes the channels
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
+
+public:
+    Q_INVOKABLE explicit QDaqDataPlayer(const QString& name);
+
+    // getters
+    QDaqObject* source() const;
+    QDaqObjectList channels() const;
+    uint position() const { return position_; }
+    bool repeat() const { return repeat_; }
+
+    // setters
+    void setSource(QDaqObject* obj);
+    void setChannels(QDaqObjectList lst);
+    void setRepeat(bool on);
+};
+
+#endif // QDAQDATAPLAYER_H
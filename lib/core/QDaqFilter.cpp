@@ -1,9 +1,12 @@
 #include "QDaqFilter.h"
 #include "QDaqChannel.h"
+#include "QDaqDataBuffer.h"
 #include "qdaqpluginloader.h"
 
+#include <climits>
+
 QDaqFilter::QDaqFilter(const QString& name) : QDaqJob(name),
-    filter_(0)
+    filter_(0), skipUnchanged_(false), blockMode_(false), blockCap_(0)
 {
 
 }
@@ -27,7 +30,6 @@ QDaqObjectList QDaqFilter::outputChannels() const
 // setters
 void QDaqFilter::setInputChannels(QDaqObjectList lst)
 {
-    if (throwIfArmed()) return;
     // check if we have valid QDaqChannels
     for(int i=0; i<lst.size(); i++)
     {
@@ -38,16 +40,31 @@ void QDaqFilter::setInputChannels(QDaqObjectList lst)
             return;
         }
     }
-    inputChannels_.clear();
-    for(int i=0; i<lst.size(); i++)
+    if (armed_ && lst.size() != nInputChannels())
     {
-        QDaqChannel* ch = qobject_cast<QDaqChannel*>(lst.at(i));
-        inputChannels_.push_back(ch);
+        throwScriptError("Incorrect number of input channels.");
+        return;
+    }
+
+    if (stageProperty("inputChannels",QVariant::fromValue(lst))) return;
+
+    {
+        os::auto_lock L(comm_lock);
+        inputChannels_.clear();
+        for(int i=0; i<lst.size(); i++)
+        {
+            QDaqChannel* ch = qobject_cast<QDaqChannel*>(lst.at(i));
+            inputChannels_.push_back(ch);
+        }
+        // the new inputs count as changed
+        if (armed_) inputUpdates_.fill(0,inputChannels_.size());
+        // in block mode they start with the next pushed samples
+        if (armed_) resetInputCounts();
     }
+    if (armed_) invalidateSchedule();
 }
 void QDaqFilter::setOutputChannels(QDaqObjectList lst)
 {
-    if (throwIfArmed()) return;
     // check if we have valid QDaqChannels
     for(int i=0; i<lst.size(); i++)
     {
@@ -58,14 +75,60 @@ void QDaqFilter::setOutputChannels(QDaqObjectList lst)
             return;
         }
     }
-    outputChannels_.clear();
-    for(int i=0; i<lst.size(); i++)
+    if (armed_ && lst.size() != nOutputChannels())
     {
-        QDaqChannel* ch = qobject_cast<QDaqChannel*>(lst.at(i));
-        outputChannels_.push_back(ch);
+        throwScriptError("Incorrect number of output channels.");
+        return;
+    }
+
+    if (stageProperty("outputChannels",QVariant::fromValue(lst))) return;
+
+    {
+        os::auto_lock L(comm_lock);
+        outputChannels_.clear();
+        for(int i=0; i<lst.size(); i++)
+        {
+            QDaqChannel* ch = qobject_cast<QDaqChannel*>(lst.at(i));
+            outputChannels_.push_back(ch);
+        }
+    }
+    if (armed_) invalidateSchedule();
+}
+
+void QDaqFilter::setSkipUnchanged(bool on)
+{
+    if (skipUnchanged_ != on)
+    {
+        if (stageProperty("skipUnchanged",on)) return;
+        {
+            os::auto_lock L(comm_lock);
+            skipUnchanged_ = on;
+        }
+        emit propertiesChanged();
+    }
+}
+
+void QDaqFilter::setBlockMode(bool on)
+{
+    if (blockMode_ != on)
+    {
+        if (stageProperty("blockMode",on)) return;
+        {
+            os::auto_lock L(comm_lock);
+            blockMode_ = on;
+            if (armed_) resetInputCounts();
+        }
+        emit propertiesChanged();
     }
 }
 
+void QDaqFilter::resetInputCounts()
+{
+    inputCounts_.resize(inputChannels_.size());
+    for(int i=0; i<inputChannels_.size(); i++)
+        inputCounts_[i] = inputChannels_[i] ? inputChannels_[i]->pushCount() : 0;
+}
+
 QStringList QDaqFilter::listPlugins()
 {
     return QDaqPluginLoader<QDaqFilterPlugin*>::findPlugins();
@@ -85,19 +148,175 @@ bool QDaqFilter::loadPlugin(const QString &fname)
     return filter_!=0;
 }
 
+bool QDaqFilter::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    writes << this;
+    for(int i=0; i<inputChannels_.size(); i++)
+        if (inputChannels_[i]) reads << inputChannels_[i].data();
+    for(int i=0; i<outputChannels_.size(); i++)
+        if (outputChannels_[i]) writes << outputChannels_[i].data();
+    return QDaqJob::dataAccess(reads,writes);
+}
+
+bool QDaqFilter::processBuffer(QDaqObject* src, QDaqObject* dst)
+{
+    if (throwIfArmed()) return false;
+    if (!filter_)
+    {
+        throwScriptError("No filter plugin loaded.");
+        return false;
+    }
+    QDaqDataBuffer* in = qobject_cast<QDaqDataBuffer*>(src);
+    QDaqDataBuffer* out = qobject_cast<QDaqDataBuffer*>(dst);
+    if (!in || !out || in==out)
+    {
+        throwScriptError("Source and destination must be different data buffers.");
+        return false;
+    }
+    int ni = nInputChannels(), no = nOutputChannels();
+    if ((int)in->columns() < ni)
+    {
+        throwScriptError("The source buffer has less than nInputChannels columns.");
+        return false;
+    }
+    if ((int)out->columns() != no)
+    {
+        throwScriptError("The destination buffer must have nOutputChannels columns.");
+        return false;
+    }
+    if (!filter_->init())
+    {
+        throwScriptError(QString("Filter initialization failed: %1").arg(filter_->errorMsg()));
+        return false;
+    }
+
+    // the input columns are read in place
+    QVector<QDaqBuffer> cols(ni);
+    QVector<const double*> pin(ni), pk(ni);
+    for(int i=0; i<ni; i++)
+    {
+        cols[i] = in->get(i);
+        pin[i] = cols[i].constData();
+    }
+    int n = in->size();
+
+    QDaqVector obuf(no*OfflineBlock);
+    QVector<double*> pout(no);
+    for(int j=0; j<no; j++) pout[j] = obuf.data() + j*OfflineBlock;
+
+    for(int k=0; k<n; k+=OfflineBlock)
+    {
+        int m = n-k < OfflineBlock ? n-k : OfflineBlock;
+        for(int i=0; i<ni; i++) pk[i] = pin[i] + k;
+        if (!filter_->process(pk.constData(), pout.constData(), m))
+        {
+            throwScriptError(QString("Filter error: %1").arg(filter_->errorMsg()));
+            return false;
+        }
+        out->pushColumns(pout.constData(), m);
+    }
+    return true;
+}
+
+bool QDaqFilter::runBlock()
+{
+    int ni = inputChannels_.size(), no = outputChannels_.size();
+
+    // frames available in all inputs
+    uint n = UINT_MAX;
+    for(int i=0; i<ni; i++)
+    {
+        QDaqChannel* ch = inputChannels_[i];
+        if (!ch) {
+            pushError("Input channel lost.");
+            return false;
+        }
+        uint c = ch->pushCount(), cap = ch->memsize();
+        uint avail = c - inputCounts_[i];
+        if (avail > cap)
+        {
+            // more samples than the channel keeps, or the channel was cleared
+            if (c >= inputCounts_[i]) pushError("Input samples lost.",ch->objectName());
+            avail = c < cap ? c : cap;
+            inputCounts_[i] = c - avail;
+        }
+        if (avail < n) n = avail;
+    }
+
+    if (!n || n==UINT_MAX)
+    {
+        nSkipped_++;
+        return QDaqJob::run();
+    }
+    nComputed_++;
+
+    // grow the blocks if needed, then copy the samples oldest first
+    if ((int)n > blockCap_)
+    {
+        blockCap_ = n;
+        blockIn_.resize(ni*blockCap_);
+        blockOut_.resize(no*blockCap_);
+        pin_.resize(ni);
+        pout_.resize(no);
+        for(int i=0; i<ni; i++) pin_[i] = blockIn_.constData() + i*blockCap_;
+        for(int j=0; j<no; j++) pout_[j] = blockOut_.data() + j*blockCap_;
+    }
+    for(int i=0; i<ni; i++)
+    {
+        QDaqChannel* ch = inputChannels_[i];
+        double* p = blockIn_.data() + i*blockCap_;
+        uint newest = ch->pushCount() - 1;
+        uint s = inputCounts_[i];
+        for(uint k=0; k<n; k++) p[k] = ch->pushed(newest - (s + k));
+        inputCounts_[i] += n;
+    }
+
+    if (!filter_->process(pin_.constData(), pout_.constData(), n)) return false;
+
+    // push the output samples
+    for(int j=0; j<no; j++)
+    {
+        QDaqChannel* ch = outputChannels_[j];
+        if (!ch) {
+            pushError("Output channel lost.");
+            return false;
+        }
+        const double* p = pout_[j];
+        for(uint k=0; k<n; k++) ch->push(p[k]);
+    }
+
+    return QDaqJob::run();
+}
+
 bool QDaqFilter::run()
 {
+    if (blockMode_) return runBlock();
+
     // get input values
+    bool changed = false;
     for(int i=0; i<inputChannels_.size(); i++)
     {
         QDaqChannel* ch = inputChannels_[i];
-        if (ch) inbuff[i]=ch->value();
+        if (ch) {
+            inbuff[i]=ch->value();
+            if (ch->updateCount() != inputUpdates_[i]) {
+                inputUpdates_[i] = ch->updateCount();
+                changed = true;
+            }
+        }
         else{
             pushError("Input channel lost.");
             return false;
         }
     }
 
+    if (skipUnchanged_ && !changed)
+    {
+        nSkipped_++;
+        return QDaqJob::run();
+    }
+    nComputed_++;
+
     bool ret = (*filter_)(inbuff.constData(), outbuff.data());
     if (!ret) return false;
 
@@ -144,6 +363,8 @@ bool QDaqFilter::arm_()
 
     inbuff.resize(inputChannels_.size());
     outbuff.resize(outputChannels_.size());
+    inputUpdates_.fill(0,inputChannels_.size());
+    resetInputCounts();
 
     return QDaqJob::arm_();
 }
@@ -18,10 +18,44 @@ class QDAQ_EXPORT QDaqFilter : public QDaqJob
     Q_PROPERTY(int nInputChannels READ nInputChannels)
     /// Number of output channels for this filter.
     Q_PROPERTY(int nOutputChannels READ nOutputChannels)
-    /// A QList of the input channels for this filter.
+    /** A QList of the input channels for this filter.
+     *
+     * If the filter is armed the list must have nInputChannels channels;
+     * the change is applied between loop cycles.
+     */
     Q_PROPERTY(QDaqObjectList inputChannels READ inputChannels WRITE setInputChannels)
-    /// A QList of the output channels for this filter.
+    /** A QList of the output channels for this filter.
+     *
+     * If the filter is armed the list must have nOutputChannels channels;
+     * the change is applied between loop cycles.
+     */
     Q_PROPERTY(QDaqObjectList outputChannels READ outputChannels WRITE setOutputChannels)
+    /** Skip the filter when its inputs are unchanged.
+     *
+     * If true, the filter plugin is called only when at least one of the input
+     * channels has been updated since the last cycle.
+     *
+     * Default is false, as stateful filters (e.g. pid, fopdt) expect to be called
+     * once per cycle.
+     */
+    Q_PROPERTY(bool skipUnchanged READ skipUnchanged WRITE setSkipUnchanged)
+    /** Process all the samples pushed to the input channels.
+     *
+     * If true, at each cycle the filter takes the values pushed to each input
+     * channel since the previous cycle, before averaging and scaling, and passes
+     * them as one block to QDaqFilterPlugin::process(). Each output channel gets
+     * one value per sample. The block length is the smallest number of new samples
+     * among the inputs; the remaining samples are used in the next cycle.
+     * If there are no new samples the filter is skipped.
+     *
+     * The input channels keep only their last memsize values, so their depth
+     * must cover the samples pushed per cycle; otherwise samples are lost
+     * and an error is reported.
+     *
+     * If false (default) the current value of each input is processed once per cycle.
+     * Can be changed while the loop is running.
+     */
+    Q_PROPERTY(bool blockMode READ blockMode WRITE setBlockMode)
 
     // the filter
     QDaqFilterPlugin* filter_;
@@ -33,6 +67,25 @@ class QDAQ_EXPORT QDaqFilter : public QDaqJob
     channel_vector_t inputChannels_, outputChannels_;
     QDaqVector inbuff, outbuff;
 
+    bool skipUnchanged_;
+    // updateCount() of input channels when last used
+    QVector<uint> inputUpdates_;
+
+    // block processing
+    bool blockMode_;
+    // pushCount() of input channels when last used
+    QVector<uint> inputCounts_;
+    // channel-wise sample blocks of blockCap_ frames and pointers to them
+    QDaqVector blockIn_, blockOut_;
+    int blockCap_;
+    QVector<const double*> pin_;
+    QVector<double*> pout_;
+    void resetInputCounts();
+    bool runBlock();
+
+    // frames per plugin call in processBuffer(), so that the blocks stay in cache
+    enum { OfflineBlock = 4096 };
+
 public:    
     Q_INVOKABLE explicit QDaqFilter(const QString& name);
 
@@ -41,10 +94,14 @@ public:
     int nOutputChannels() const { return filter_ ? filter_->nOutputChannels() : 0; }
     QDaqObjectList inputChannels() const;
     QDaqObjectList outputChannels() const;
+    bool skipUnchanged() const { return skipUnchanged_; }
+    bool blockMode() const { return blockMode_; }
 
     // setters
     void setInputChannels(QDaqObjectList lst);
     void setOutputChannels(QDaqObjectList lst);
+    void setSkipUnchanged(bool on);
+    void setBlockMode(bool on);
 
 public slots:
     /**
@@ -60,10 +117,26 @@ public slots:
      * @return True if the plugin is sucessfully loaded.
      */
     bool loadPlugin(const QString& fname);
+    /**
+     * @brief Process the data of a QDaqDataBuffer offline.
+     *
+     * The first nInputChannels columns of src are passed through the filter
+     * in blocks and the output is appended to dst, which must have
+     * nOutputChannels columns. The filter plugin is initialized first.
+     *
+     * The filter must not be armed.
+     *
+     * @param src The QDaqDataBuffer with the input data.
+     * @param dst The QDaqDataBuffer receiving the output.
+     * @return True if the data were processed.
+     */
+    bool processBuffer(QDaqObject* src, QDaqObject* dst);
 
 protected:
     virtual bool arm_();
     virtual bool run();
+    // reads the input channels, writes the output channels
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
 
 };
 
@@ -2,6 +2,7 @@
 #define QDAQFILTERPLUGIN_H
 
 #include <QtPlugin>
+#include <QVarLengthArray>
 
 class QDaqFilterPlugin
 {
@@ -15,10 +16,36 @@ public:
 
     virtual int nInputChannels() const = 0;
     virtual int nOutputChannels() const = 0;
+
+    /**
+     * @brief Process a block of nframes samples per channel.
+     *
+     * in[i] points to nframes consecutive samples of input i, oldest first,
+     * and out[j] receives nframes samples of output j.
+     *
+     * The default implementation calls operator() for each frame.
+     * Plugins reimplement it to process whole blocks without a virtual call
+     * per sample.
+     *
+     * @return false if an error occured.
+     */
+    virtual bool process(const double* const* in, double* const* out, int nframes)
+    {
+        int ni = nInputChannels(), no = nOutputChannels();
+        QVarLengthArray<double, 16> vin(ni), vout(no);
+        for(int k=0; k<nframes; ++k)
+        {
+            for(int i=0; i<ni; ++i) vin[i] = in[i][k];
+            if (!(*this)(vin.constData(), vout.data())) return false;
+            for(int j=0; j<no; ++j) out[j][k] = vout[j];
+        }
+        return true;
+    }
 };
 
-/// An identifier to be used in IID metadata of filter plugins
-#define QDaqFilterPlugin_iid "org.qdaq.filterplugin"
+/// An identifier to be used in IID metadata of filter plugins.
+/// Changed when process() was added, so that older binaries are not loaded.
+#define QDaqFilterPlugin_iid "org.qdaq.filterplugin/2"
 
 Q_DECLARE_INTERFACE(QDaqFilterPlugin, QDaqFilterPlugin_iid)
 
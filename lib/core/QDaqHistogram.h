@@ -0,0 +1,119 @@
+#ifndef QDAQHISTOGRAM_H
+#define QDAQHISTOGRAM_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+
+#include <cmath>
+
+/**
+ * @brief A log-linear histogram of time intervals.
+ *
+ * @ingroup Core
+ *
+ * Values are durations in ns. Values below 2^SubBits ns are counted exactly,
+ * larger ones in buckets whose width is 1/2^(SubBits-1) of their value.
+ * The range extends to 2^MaxBits ns, larger values go to the last bucket.
+ *
+ * The memory is fixed (see NBuckets) and record() is a single atomic increment,
+ * so it can be called from a real-time thread while other threads
+ * read the histogram or reset() it.
+ *
+ * This is a simplified version of the HdrHistogram of Gil Tene.
+ *
+ * QDaqHistogram has about 2 significant digits (1.6% resolution)
+ * and a range of about 18 min. QDaqCoarseHistogram (6% resolution, 68 s)
+ * takes 1 kB and is used for the per-job profiles.
+ */
+template<int SubBits, int MaxBits>
+class QDaqHistogramT
+{
+public:
+    enum {
+        SubHalf = 1 << (SubBits - 1),
+        NBuckets = (MaxBits - SubBits + 2) * SubHalf
+    };
+
+    QDaqHistogramT() {}
+
+    /// Count a value (ns)
+    void record(qint64 v) { counts_[index(v)].fetchAndAddRelaxed(1); }
+    /// Clear all counts
+    void reset()
+    {
+        for(int i=0; i<NBuckets; ++i) counts_[i].fetchAndStoreRelaxed(0);
+    }
+
+    /// Total number of recorded values
+    quint64 count() const
+    {
+        quint64 n = 0;
+        for(int i=0; i<NBuckets; ++i) n += (uint)counts_[i].load();
+        return n;
+    }
+    /// The value (ns) below or at which lies the given percentage (0-100) of the recorded values
+    qint64 percentile(double p) const
+    {
+        quint64 n = count();
+        if (!n) return 0;
+        if (p > 100.) p = 100.;
+        quint64 target = (quint64)ceil(p/100*n);
+        if (target < 1) target = 1;
+        quint64 m = 0;
+        for(int i=0; i<NBuckets; ++i)
+        {
+            m += (uint)counts_[i].load();
+            if (m >= target) return highestValue(i);
+        }
+        // values were recorded while counting
+        return max();
+    }
+    /// The largest recorded value (ns), at the resolution of the histogram
+    qint64 max() const
+    {
+        for(int i=NBuckets-1; i>=0; --i)
+            if (counts_[i].load()) return highestValue(i);
+        return 0;
+    }
+
+    /// Bucket of value v
+    static int index(qint64 v)
+    {
+        if (v < (1 << SubBits)) return v<0 ? 0 : (int)v;
+        if (v >> MaxBits) return NBuckets - 1;
+        // v is in the octave [2^e, 2^(e+1)), split in SubHalf buckets of width 2^k
+        int k = msb(v) - SubBits + 1;
+        return k*SubHalf + (int)(v >> k);
+    }
+    /// Largest value counted in bucket i
+    static qint64 highestValue(int i)
+    {
+        if (i < (1 << SubBits)) return i;
+        int k = i/SubHalf - 1;
+        qint64 sub = i - k*SubHalf;
+        return ((sub + 1) << k) - 1;
+    }
+
+private:
+    QAtomicInt counts_[NBuckets];
+
+    // position of the most significant bit, v>0
+    static int msb(quint64 v)
+    {
+        int n = 0;
+        if (v >> 32) { v >>= 32; n += 32; }
+        if (v >> 16) { v >>= 16; n += 16; }
+        if (v >> 8)  { v >>= 8;  n += 8; }
+        if (v >> 4)  { v >>= 4;  n += 4; }
+        if (v >> 2)  { v >>= 2;  n += 2; }
+        if (v >> 1)  { n += 1; }
+        return n;
+    }
+
+    Q_DISABLE_COPY(QDaqHistogramT)
+};
+
+typedef QDaqHistogramT<7,40> QDaqHistogram;
+typedef QDaqHistogramT<4,36> QDaqCoarseHistogram;
+
+#endif // QDAQHISTOGRAM_H
@@ -1,12 +1,31 @@
 #include "QDaqJob.h"
+#include "QDaqJobPool.h"
+#include "QDaqScheduler.h"
+#include "QDaqWatchdog.h"
 #include "QDaqSession.h"
 
+#include <QStringList>
+#include <QVector>
+#include <QThread>
+#include <QScriptEngine>
+#include <QPair>
+#include <QtAlgorithms>
+
+#include <climits>
+
+#include "QDaqEnumHelper.h"
+
+Q_SCRIPT_ENUM(OverrunPolicy,QDaqLoop)
+Q_SCRIPT_ENUM(BudgetAction,QDaqLoop)
+
 QDaqJob::QDaqJob(const QString& name) :
-    QDaqObject(name), armed_(false), program_(0), isLoop_(false)
+    QDaqObject(name), armed_(false), program_(0), isLoop_(false),
+    nComputed_(0), nSkipped_(0), prof_(0), budget_(0), runStart_(0), skip_(0), budgetOverruns_(0)
 {
 }
 QDaqJob::~QDaqJob(void)
 {
+    delete prof_;
 }
 void QDaqJob::attach()
 {
@@ -28,12 +47,45 @@ bool QDaqJob::exec()
     //** Job has been locked at the QDaqLoop level
 	if (armed_)
 	{
+        // skipped after a budget overrun
+        if (skip_)
+        {
+            skip_--;
+            return true;
+        }
         // run this job's task
         // and then execute all child tasks
-        ret = run() && subjobs_.exec();
+        ret = profiledRun() && subjobs_.exec();
 	}
     return ret;
 }
+bool QDaqJob::timedRun()
+{
+    // a loop's budget is checked for the whole cycle in QDaqLoop::exec()
+    bool watched = budget_ && !isLoop_;
+    qint64 t = os::clock_ns();
+    if (watched) runStart_ = t;
+    bool ret = run();
+    t = os::clock_ns() - t;
+    if (prof_) prof_->record(t);
+    if (watched)
+    {
+        runStart_ = 0;
+        if (t > budget_)
+        {
+            budgetOverruns_++;
+            QDaqLoop* l = loop();
+            if (l) l->containOverrun(this, QString("Job took %1 ms, budget %2 ms")
+                                     .arg(1.e-6*t,0,'f',3).arg(1.e-6*budget_,0,'f',3));
+        }
+    }
+    return ret;
+}
+void QDaqJob::budgetStall(qint64 elapsed) const
+{
+    pushError("Budget exceeded", QString("Job still running after %1 ms, budget %2 ms")
+              .arg(1.e-6*elapsed,0,'f',1).arg(1.e-6*budget_,0,'f',1));
+}
 bool QDaqJob::run()
 {
     QString msg;
@@ -51,9 +103,13 @@ bool QDaqJob::run()
     }
     return true;
 }
-bool QDaqJob::arm_()
+bool QDaqJob::compileCode()
 {
-    //disarm_();
+    if (program_)
+    {
+        delete program_;
+        program_ = 0;
+    }
 
     if (!code_.isEmpty())
     {
@@ -71,12 +127,26 @@ bool QDaqJob::arm_()
 
         program_ = new QScriptProgram(code_,objectName() + "_code");
     }
+    return true;
+}
+bool QDaqJob::arm_()
+{
+    //disarm_();
+
+    if (!compileCode()) return false;
 
+    nComputed_ = nSkipped_ = 0;
+    skip_ = budgetOverruns_ = 0;
+    runStart_ = 0;
+    if (budget_ && !QDaqWatchdog::instance()->add(this))
+        pushError("Watchdog thread failed to start");
     armed_ = true;
     return armed_;
 }
 void QDaqJob::disarm_()
 {
+    // also waits for a watchdog scan that may still see this job running
+    QDaqWatchdog::instance()->remove(this);
     if (program_)
     {
         delete program_;
@@ -89,12 +159,16 @@ bool QDaqJob::setArmed(bool on)
 {
     if (on == armed_) return armed_;
 
+    // the loop must not run while the job tree changes
+    LoopPause P(this);
+
     if (armed_) // disarm
     {
         jobLock();
         disarm_();
         foreach(QDaqJob* j, subjobs_) j->setArmed(false);
         armed_ = false;
+        invalidateSchedule();
         jobUnlock();
     }
     else // arm
@@ -118,6 +192,14 @@ bool QDaqJob::setArmed(bool on)
             ++i;
         }
 
+        // put my sub-jobs in dependency order
+        QString cycle;
+        if (ok && !subjobs_.sort(this,cycle))
+        {
+            throwScriptError(QString("Circular dependency between jobs: %1").arg(cycle));
+            ok = false;
+        }
+
 
         // Some job failed to arm.
         // the job that failed must send an error
@@ -129,8 +211,15 @@ bool QDaqJob::setArmed(bool on)
                 if (!j->isLoop_) j->setArmed(false);
             armed_ = false;
         }
-        else arm_();
+        else
+        {
+            // a job armed under a profiled loop gets its profile
+            if (!prof_ && profilingRequested()) prof_ = new Profile;
+            arm_();
+        }
 
+        // the loops must see the change before they can lock me again
+        invalidateSchedule();
 
         jobUnlock();
 
@@ -138,26 +227,382 @@ bool QDaqJob::setArmed(bool on)
 	emit propertiesChanged();
 	return armed_;
 }
-void QDaqJob::setCode(const QString& s)
+void QDaqJob::dependencies(QList<QDaqJob*>& lst) const
 {
-    if (s==code_) return;
+    Q_UNUSED(lst);
+}
+void QDaqJob::collectDependencies(QList<QDaqJob*>& lst) const
+{
+    if (!armed_) return;
+    dependencies(lst);
+    foreach(QDaqJob* j, subjobs_) j->collectDependencies(lst);
+}
+bool QDaqJob::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    Q_UNUSED(reads);
+    Q_UNUSED(writes);
+    return code_.isEmpty();
+}
+bool QDaqJob::collectDataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    if (!armed_) return false;
+    bool ok = dataAccess(reads,writes);
+    foreach(QDaqJob* j, subjobs_)
+        if (!j->collectDataAccess(reads,writes)) ok = false;
+    return ok;
+}
+void QDaqJob::invalidateSchedule()
+{
+    QDaqLoop* l = isLoop_ ? ((QDaqLoop*)this)->parentLoop() : loop();
+    while (l)
+    {
+        l->scheduleDirty_.storeRelease(1);
+        l = l->parentLoop();
+    }
+}
+bool QDaqJob::sortParents(QString& cycle, bool apply)
+{
+    QDaqJob* p = qobject_cast<QDaqJob*>(parent());
+    while (p && p->armed_)
+    {
+        JobList lst = p->subjobs_;
+        if (!lst.sort(p,cycle)) return false;
+        if (apply) p->subjobs_ = lst;
+        p = qobject_cast<QDaqJob*>(p->parent());
+    }
+    return true;
+}
+bool QDaqJob::profilingRequested() const
+{
+    for(const QDaqJob* j = this; j; j = j->isLoop_ ? ((const QDaqLoop*)j)->parentLoop() : j->loop())
+        if (j->isLoop_ && ((const QDaqLoop*)j)->profiling_) return true;
+    return false;
+}
+void QDaqJob::setProfiled(bool on)
+{
+    if (on && !prof_) prof_ = new Profile;
+    else if (!on && prof_)
+    {
+        delete prof_;
+        prof_ = 0;
+    }
+    // profiled jobs are not fused
+    if (armed_) invalidateSchedule();
+    foreach(QDaqObject* obj, children_)
+    {
+        QDaqJob* j = qobject_cast<QDaqJob*>(obj);
+        // child loops that are profiled themselves keep their profiles
+        if (j && (on || !j->isLoop_ || !((QDaqLoop*)j)->profiling_)) j->setProfiled(on);
+    }
+}
+void QDaqJob::clearProfile()
+{
+    if (prof_) prof_->reset();
+    foreach(QDaqObject* obj, children_)
+    {
+        QDaqJob* j = qobject_cast<QDaqJob*>(obj);
+        if (j) j->clearProfile();
+    }
+}
+uint QDaqJob::jobCount() const
+{
+    if (!armed_) return 0;
+    uint n = 1;
+    foreach(QDaqJob* j, subjobs_) n += j->jobCount();
+    return n;
+}
+qint64 QDaqJob::profileTotal() const
+{
+    qint64 t = prof_ ? prof_->total : 0;
+    foreach(QDaqObject* obj, children_)
+    {
+        QDaqJob* j = qobject_cast<QDaqJob*>(obj);
+        if (j) t += j->profileTotal();
+    }
+    return t;
+}
+void QDaqJob::profileReport(QString& S, int level, qint64 loopTotal) const
+{
+    QString pre;
+    if (level)
+    {
+        int k = level;
+        pre.prepend("|--"); k--;
+        while (k)
+        {
+            pre.prepend("|  "); k--;
+        }
+    }
+    if (prof_)
+    {
+        quint64 n = prof_->count;
+        S += QString("%1%2%3%4%5%6%7%8\n")
+                .arg(pre + objectName(),-32)
+                .arg(n,10)
+                .arg(1.e-6*prof_->total,12,'f',3)
+                .arg(loopTotal ? 100.*prof_->total/loopTotal : 0.,7,'f',1)
+                .arg(1.e-6*profileTotal(),12,'f',3)
+                .arg(n ? 1.e-3*prof_->total/n : 0.,10,'f',1)
+                .arg(1.e-3*prof_->hist.percentile(99.),10,'f',1)
+                .arg(1.e-3*prof_->max,10,'f',1);
+    }
+    else S += pre + objectName() + '\n';
 
+    // children by decreasing self time
+    QList< QPair<qint64, QDaqJob*> > lst;
+    foreach(QDaqObject* obj, children_)
     {
-        bool onlineChange = armed_;
-        if (onlineChange)
+        QDaqJob* j = qobject_cast<QDaqJob*>(obj);
+        if (j) lst << qMakePair(j->prof_ ? j->prof_->total : qint64(0), j);
+    }
+    qStableSort(lst.begin(), lst.end(), selfTimeGreater);
+    for(int i=0; i<lst.size(); ++i) lst[i].second->profileReport(S, level+1, loopTotal);
+}
+bool QDaqJob::selfTimeGreater(const QPair<qint64, QDaqJob*>& a, const QPair<qint64, QDaqJob*>& b)
+{
+    return a.first > b.first;
+}
+void QDaqJob::changeStat(uint& computed, uint& skipped) const
+{
+    computed += nComputed_;
+    skipped += nSkipped_;
+    foreach(QDaqJob* j, subjobs_) j->changeStat(computed,skipped);
+}
+bool QDaqJob::JobList::sort(const QDaqJob* owner, QString& cycle)
+{
+    int n = size();
+
+    // succ[j] : sub-jobs that must run after sub-job j
+    QVector< QList<int> > succ(n);
+    // number of sub-jobs that must run before sub-job i
+    QVector<int> npred(n,0);
+    bool hasEdges = false;
+
+    for(int i=0; i<n; ++i)
+    {
+        QList<QDaqJob*> deps;
+        at(i)->collectDependencies(deps);
+        foreach(QDaqJob* d, deps)
         {
-            jobLock();
-            disarm_();
+            // find the ancestor of d that is a sub-job of owner
+            QDaqObject* p = d;
+            while(p && p->parent()!=owner) p = p->parent();
+            int j = indexOf(qobject_cast<QDaqJob*>(p));
+            if (j<0 || j==i || succ[j].contains(i)) continue;
+            succ[j] << i;
+            npred[i]++;
+            hasEdges = true;
+        }
+    }
+
+    if (!hasEdges) return true;
+
+    // Kahn's algorithm. Among the jobs that are ready to run
+    // always select the one that comes first in tree order
+    QList<QDaqJob*> sorted;
+    QVector<bool> done(n,false);
+    while (sorted.size()<n)
+    {
+        int k = 0;
+        while (k<n && (done[k] || npred[k])) k++;
+        if (k==n)
+        {
+            QStringList names;
+            for(int i=0; i<n; ++i)
+                if (!done[i]) names << at(i)->objectName();
+            cycle = names.join(", ");
+            return false;
         }
+        done[k] = true;
+        sorted << at(k);
+        foreach(int j, succ[k]) npred[j]--;
+    }
+
+    QList<QDaqJob*>::operator=(sorted);
+    return true;
+}
+void QDaqJob::ExecPlan::clear()
+{
+    steps_.clear();
+    foreach(Chunk* c, chunks_)
+    {
+        delete c->program;
+        delete c;
+    }
+    chunks_.clear();
+    run_.clear();
+}
+void QDaqJob::ExecPlan::build(const JobList& jobs, bool fuse)
+{
+    clear();
+    fuse_ = fuse;
+    foreach(QDaqJob* j, jobs) append(j);
+    flush();
+}
+bool QDaqJob::ExecPlan::fusable(const QDaqJob* j)
+{
+    // a plain script job without sub-jobs, that is not timed
+    return j->armed_ && !j->isLoop_ && j->metaObject()==&QDaqJob::staticMetaObject &&
+            j->program_ && j->subjobs_.isEmpty() && !j->budget_ && !j->prof_;
+}
+void QDaqJob::ExecPlan::appendStep(QDaqJob* j, step_fn fn, int chunk)
+{
+    Step s;
+    s.fn = fn;
+    s.job = j;
+    s.next = steps_.size()+1;
+    s.chunk = chunk;
+    steps_ << s;
+}
+void QDaqJob::ExecPlan::flush()
+{
+    if (run_.isEmpty()) return;
+    if (run_.size()==1)
+    {
+        appendStep(run_.first(),runJob,-1);
+        run_.clear();
+        return;
+    }
+
+    // the codes one after the other, each terminated in case of a missing ;
+    Chunk* c = new Chunk;
+    QString src;
+    int line = 1;
+    foreach(QDaqJob* j, run_)
+    {
+        QString code = j->code_ + "\n;\n";
+        c->jobs << j;
+        c->lines << line;
+        line += code.count('\n');
+        src += code;
+    }
+    QDaqJob* first = run_.first();
+    c->engine = first->loop_eng_;
+    c->program = new QScriptProgram(src, first->path() + "_fused");
+    appendStep(first,0,chunks_.size());
+    chunks_ << c;
+    run_.clear();
+}
+void QDaqJob::ExecPlan::append(QDaqJob* j)
+{
+    if (fuse_ && fusable(j))
+    {
+        // joined with the script jobs right before it, in the same engine
+        if (!run_.isEmpty() && run_.first()->loop_eng_!=j->loop_eng_) flush();
+        run_ << j;
+        return;
+    }
+    flush();
+
+    int k = steps_.size();
+    step_fn fn;
+    if (j->isLoop_) fn = execJob;
+    else if (j->metaObject()==&QDaqJob::staticMetaObject && j->code_.isEmpty())
+        fn = 0; // a plain container job
+    else fn = runJob;
+    appendStep(j,fn,-1);
+
+    // the sub-jobs of unarmed jobs may be outdated
+    if (j->isLoop_ || !j->armed_) return;
+    foreach(QDaqJob* c, j->subjobs_) append(c);
+    // a run of script jobs ends with the sub-tree, which is skipped as a whole
+    flush();
+    steps_[k].next = steps_.size();
+}
+bool QDaqJob::ExecPlan::runChunk(const Chunk* c)
+{
+    // disarmed or skipped jobs are left out, then each job runs by itself
+    foreach(QDaqJob* j, c->jobs)
+    {
+        if (j->armed_ && !j->skip_) continue;
+        foreach(QDaqJob* k, c->jobs)
+            if (!k->exec()) return false;
+        return true;
+    }
+
+    QDaqJob* first = c->jobs.first();
+    if (!c->engine) {
+        first->pushError("Loop script engine not available");
+        return false;
+    }
+    QString msg;
+    if (c->engine->evaluate(*c->program,msg)) return true;
+
+    // find the job from the line of the error
+    int line = c->engine->getEngine()->uncaughtExceptionLineNumber();
+    int k = 0;
+    while (k+1 < c->lines.size() && c->lines[k+1] <= line) k++;
+    c->jobs.value(k,first)->pushError("Error executing script job",msg);
+    return false;
+}
+void QDaqJob::setCode(const QString& s)
+{
+    if (s==code_) return;
+
+    // report syntax errors now, as a staged change is compiled later
+    if (armed_ && QScriptEngine::checkSyntax(s).state()==QScriptSyntaxCheckResult::Error)
+    {
+        throwScriptError("Error in job script code.");
+        return;
+    }
+
+    if (stageProperty("code",s)) return;
+
+    {
         code_ = s;
-        if (onlineChange)
+        if (armed_)
         {
-            arm_();
+            // compile the new code; it runs from the next cycle,
+            // the job stays armed and the loop keeps running
+            jobLock();
+            compileCode();
+            invalidateSchedule();
             jobUnlock();
         }
         emit propertiesChanged();
     }
 }
+void QDaqJob::setBudget(double ms)
+{
+    if (ms<0.)
+    {
+        throwScriptError("Budget must be >= 0.");
+        return;
+    }
+    qint64 b = (qint64)(ms*1.e6 + 0.5);
+    if (b==budget_) return;
+
+    // read by the loop thread at each cycle
+    if (stageProperty("budget",ms)) return;
+    budget_ = b;
+    if (armed_)
+    {
+        if (budget_) QDaqWatchdog::instance()->add(this);
+        else QDaqWatchdog::instance()->remove(this);
+        // jobs with a budget are not fused
+        invalidateSchedule();
+    }
+    emit propertiesChanged();
+}
+bool QDaqJob::stageProperty(const char* name, const QVariant& value)
+{
+    QDaqLoop* top = topLoop();
+    return top && top->stage(this,name,value,true);
+}
+bool QDaqJob::stageCall(const char* slot)
+{
+    QDaqLoop* top = topLoop();
+    return top && top->stage(this,slot,QVariant(),false);
+}
+QDaqJob::LoopPause::LoopPause(const QDaqJob* j) : top_(j->topLoop())
+{
+    // a top loop stops its own thread when disarmed
+    if (top_==j || (top_ && !top_->pause())) top_ = 0;
+}
+QDaqJob::LoopPause::~LoopPause()
+{
+    if (top_) top_->resume();
+}
 QDaqLoop* QDaqJob::topLoop() const
 {
     QDaqObject* p = (QDaqObject*)this;
@@ -195,9 +640,17 @@ QDaqScriptEngine* QDaqJob::loopEngine() const
 }
 //////////////////// QDaqLoop //////////////////////////////////////////
 QDaqLoop::QDaqLoop(const QString& name) :
-    QDaqJob(name), count_(0), limit_(0), delay_(0), preload_(0), period_(1000)
+    QDaqJob(name), count_(0), limit_(0), delay_(0), preload_(0), period_(1000000),
+    parallel_(false), threads_(0), rtPriority_(0), cpuAffinity_(-1), lockMemory_(false),
+    profiling_(false), overrunPolicy_(Skip), tmissReport_(0.), missedUnreported_(0),
+    virtualClock_(false), speed_(0.), startTime_(0.), vtime_(0.), vcontinue_(0),
+    sharedTimer_(false), scheduled_(false), pool_(0), autoPhase_(false), phase_(0), cycleLoad_(0),
+    fuseScripts_(false), execPlan_(true), budgetAction_(LogOnly), budgetSkip_(10), current_(0),
+    loopOverruns_(0), tbudgetReport_(0.), budgetUnreported_(0), threadId_(0),
+    reconfigured_(false), reconfigGap_(0.), reconfigurations_(0)
 {
     isLoop_ = true;
+    vrunner_.loop = this;
     connect(this,SIGNAL(abort()),this,SLOT(disarm()),Qt::QueuedConnection);
 }
 QDaqLoop::~QDaqLoop(void)
@@ -209,29 +662,40 @@ bool QDaqLoop::exec()
 
     if (aborted_) return false;
 
+    // a child loop skipped after a budget overrun
+    if (skip_)
+    {
+        skip_--;
+        return true;
+    }
+
     // check time for loop statistics
-    t_[1] = (float)clock_.sec();
+    t_[1] = clock_.sec();
 
     bool ret = true;
-    comm_lock.lock();
+    ExecPlan::Longest longest;
+    // No locking here: the job tree is modified by other
+    // threads only while the top loop is between cycles
     if (delay_counter_) delay_counter_--;
     if (delay_counter_ == 0) // loop executes
     {
-        // Lock  subjobs
-        subjobs_.lock();
-        // call base-class exec
-        ret = QDaqJob::exec();
+        // rebuild the plan / dependency graph if some job changed
+        if (scheduleDirty_.testAndSetOrdered(1,0)) rebuildSchedule();
+        // the cycle is watched if there is a budget
+        if (budget_) runStart_ = os::clock_ns();
+        // run my code and then the job tree or the subjobs in the pool
+        if (pool_) ret = profiledRun() && pool_->exec();
+        else if (!execPlan_) ret = profiledRun() && subjobs_.exec();
+        else if (budget_) ret = profiledRun() && plan_.exec(current_,&longest);
+        else ret = profiledRun() && plan_.exec(current_);
         // reset counter
         delay_counter_ = delay_;
         // increase count
         count_++;
-        // unlock everything in reverse order
-        subjobs_.unlock();
 
-        emit propertiesChanged();
-        emit updateWidgets();
+        // delivered at the next GUI frame
+        notifyGui(PropertiesChanged | WidgetsUpdate);
     }
-    comm_lock.unlock();
 
     if (ret && limit_ && count_>=limit_)  ret = false;
 
@@ -240,31 +704,454 @@ bool QDaqLoop::exec()
         emit abort();
     }
 
-    // loop statistics
-    perfmon[0] << (t_[1] - t_[0])*1000; t_[0] = t_[1];
-    perfmon[1] << ((float)clock_.sec() - t_[1])*1000;
+    // gap caused by changes applied before this cycle
+    if (reconfigured_)
+    {
+        if (t_[1] - t_[0] > reconfigGap_) reconfigGap_ = t_[1] - t_[0];
+        reconfigurations_++;
+        reconfigured_ = false;
+    }
+
+    // loop statistics (ns)
+    qint64 load = (qint64)((clock_.sec() - t_[1])*1.e9);
+    hist_[PeriodHist].record((qint64)((t_[1] - t_[0])*1.e9)); t_[0] = t_[1];
+    hist_[LoadHist].record(load);
+
+    // the cycle budget; the job that took longest is contained
+    if (runStart_)
+    {
+        runStart_ = 0;
+        if (load > budget_)
+        {
+            budgetOverruns_++;
+            QString msg = QString("Cycle took %1 ms, budget %2 ms")
+                    .arg(1.e-6*load,0,'f',3).arg(1.e-6*budget_,0,'f',3);
+            if (longest.job)
+                msg += QString(", longest job %1 took %2 ms")
+                        .arg(longest.job->objectName()).arg(1.e-6*longest.t,0,'f',3);
+            containOverrun(longest.job,msg);
+        }
+    }
 
     return ret;
 }
 
+void QDaqLoop::containOverrun(QDaqJob* j, const QString& msg)
+{
+    // may be called by the pool threads of a parallel loop
+    QMutexLocker L(&budgetMtx_);
+    loopOverruns_++;
+    if (j) overrunJob_ = j->path();
+
+    QString S = msg;
+    if (j && budgetAction_==SkipJob)
+    {
+        if (j->skip_ < budgetSkip_) j->skip_ = budgetSkip_;
+        S += QString(", skipped for %1 cycles").arg(budgetSkip_);
+    }
+    else if (j && budgetAction_==DisarmJob)
+    {
+        // stop running it now, disarm outside the cycle
+        j->skip_ = UINT_MAX;
+        QMetaObject::invokeMethod(j,"budgetDisarm",Qt::QueuedConnection);
+        S += ", disarmed";
+    }
+
+    // report at most once per second, except disarming
+    double t = clock_.sec();
+    if (t - tbudgetReport_ < 1. && !(j && budgetAction_==DisarmJob))
+    {
+        budgetUnreported_++;
+        return;
+    }
+    if (budgetUnreported_)
+        S += QString(" (%1 more overruns since the last report)").arg(budgetUnreported_);
+    tbudgetReport_ = t;
+    budgetUnreported_ = 0;
+    if (j) j->pushError("Budget exceeded",S);
+    else pushError("Budget exceeded",S);
+}
+
+void QDaqLoop::budgetStall(qint64 elapsed) const
+{
+    // follow the running jobs down the child loops
+    const QDaqJob* j = this;
+    const QDaqJob* c = current_;
+    while (c)
+    {
+        j = c;
+        c = c->isLoop_ ? ((const QDaqLoop*)c)->current_ : 0;
+    }
+    pushError("Budget exceeded", QString("Cycle still running after %1 ms, budget %2 ms, in %3")
+              .arg(1.e-6*elapsed,0,'f',1).arg(1.e-6*budget_,0,'f',1).arg(j->path()));
+}
+
+QString QDaqLoop::overrunJob()
+{
+    QMutexLocker L(&budgetMtx_);
+    return overrunJob_;
+}
+
 bool QDaqLoop::arm_()
 {
     count_ = 0;
     delay_counter_ = preload_;
+    phase_ = preload_ > 1 ? preload_ - 1 : 0;
     aborted_ = false;
     bool ret = QDaqJob::arm_();
     if (ret)
     {
+        // compile the job tree
+        if (parallel_)
+        {
+            int n = threads_ ? threads_ : QThread::idealThreadCount() - 1;
+            pool_ = new QDaqJobPool(n < 1 ? 1 : n);
+        }
+        rebuildSchedule();
+        scheduleDirty_.storeRelease(0);
+
+        // changes left over from the previous run
+        applyStaged();
+
+        resetStats();
+        reconfigured_ = false;
+        {
+            QMutexLocker L(&budgetMtx_);
+            overrunJob_.clear();
+            loopOverruns_ = 0;
+        }
+        tbudgetReport_ = -1.;
+        budgetUnreported_ = 0;
+        missed_.storeRelease(0);
+        overruns_.storeRelease(0);
+        missedUnreported_ = 0;
         clock_.start();
-        t_[0] = (float)clock_.sec();
-        if (isTop()) armed_ = thread_.start(this,period_); //,THREAD_PRIORITY_TIME_CRITICAL);
+        t_[0] = clock_.sec();
+        tmissReport_ = -1.;
+        if (isTop() && virtualClock_)
+        {
+            vtime_ = startTime_ ? startTime_ : (double)QDaqTimeValue::now();
+            vcontinue_ = 1;
+            armed_ = vthread_.start(&vrunner_);
+        }
+        else if (isTop() && sharedTimer_)
+        {
+            armed_ = scheduled_ = QDaqScheduler::instance()->add(this,period_);
+        }
+        else if (isTop())
+        {
+            thread_.set_priority(rtPriority_);
+            thread_.set_cpu(cpuAffinity_);
+            thread_.set_lock_memory(lockMemory_);
+            armed_ = thread_.start(this,period_);
+            if (armed_ && *thread_.error())
+                pushError("Real-time setup of loop thread failed",thread_.error());
+        }
     }
     return armed_;
 }
 
+bool QDaqLoop::timerCycle(qint64 latency, uint missed)
+{
+    threadId_ = QThread::currentThreadId();
+
+    // give way to threads waiting to modify the job tree
+    forever
+    {
+        inCycle_.fetchAndStoreOrdered(1);
+        if (!pauseRequests_.loadAcquire()) break;
+        reconfigured_ = true;
+        QMutexLocker L(&pauseMtx_);
+        inCycle_.fetchAndStoreOrdered(0);
+        pauseCond_.wakeAll();
+        while (pauseRequests_.loadAcquire()) pauseCond_.wait(&pauseMtx_);
+    }
+
+    if (latency>=0) hist_[LatencyHist].record(latency);
+
+    if (applyStaged()) reconfigured_ = true;
+
+    // timer periods that elapsed during the previous cycle
+    int extra = missed ? overrun(missed) : 0;
+
+    bool ret;
+    if (extra<0)
+    {
+        aborted_ = true;
+        emit abort();
+        ret = false;
+    }
+    else
+    {
+        ret = exec();
+        // catch up
+        while (ret && extra--) ret = exec();
+    }
+
+    // scheduler workers run other loops as well
+    threadId_ = 0;
+    inCycle_.fetchAndStoreOrdered(0);
+    if (pauseRequests_.loadAcquire())
+    {
+        QMutexLocker L(&pauseMtx_);
+        pauseCond_.wakeAll();
+    }
+    return ret;
+}
+
+void QDaqLoop::rebuildSchedule()
+{
+    if (pool_) pool_->setJobs(subjobs_);
+    else plan_.build(subjobs_,fuseScripts_);
+    balancePhases();
+}
+
+// a child loop in phase balancing
+struct PhaseItem
+{
+    QDaqLoop* loop;
+    uint delay, weight;
+};
+// rate-monotonic order: faster loops first, heavier first at equal rates
+static bool rateMonotonic(const PhaseItem& a, const PhaseItem& b)
+{
+    return a.delay < b.delay || (a.delay == b.delay && a.weight > b.weight);
+}
+static uint gcd(uint a, uint b)
+{
+    while (b) { uint t = a % b; a = b; b = t; }
+    return a;
+}
+#define MAX_PHASE_CYCLES 4096 // length of the load profile
+
+void QDaqLoop::balancePhases()
+{
+    // armed child loops; the rest runs at every cycle
+    QVector<PhaseItem> items;
+    uint base = jobCount();
+    foreach(QDaqJob* j, subjobs_)
+    {
+        QDaqLoop* l = qobject_cast<QDaqLoop*>(j);
+        if (!l || !l->armed()) continue;
+        PhaseItem it;
+        it.loop = l;
+        it.delay = l->delay_ > 1 ? l->delay_ : 1;
+        it.weight = l->jobCount();
+        base -= it.weight;
+        items << it;
+    }
+
+    // the load profile covers the hyper-period of the child loops, up to a limit
+    uint H = 1;
+    foreach(const PhaseItem& it, items)
+    {
+        quint64 h = (quint64)H / gcd(H,it.delay) * it.delay;
+        H = h > MAX_PHASE_CYCLES ? MAX_PHASE_CYCLES : (uint)h;
+    }
+    QVector<uint> load(H, base);
+
+    qStableSort(items.begin(), items.end(), rateMonotonic);
+    foreach(const PhaseItem& it, items)
+    {
+        QDaqLoop* l = it.loop;
+        uint d = it.delay, p = 0;
+        if (autoPhase_)
+        {
+            // the phase with the lowest peak load, then the lowest total
+            uint bestPeak = UINT_MAX;
+            quint64 bestSum = 0;
+            for(uint q=0; q<d && q<H; ++q)
+            {
+                uint peak = 0;
+                quint64 sum = 0;
+                for(uint t=q; t<H; t+=d)
+                {
+                    if (load[t] > peak) peak = load[t];
+                    sum += load[t];
+                }
+                if (peak < bestPeak || (peak == bestPeak && sum < bestSum))
+                {
+                    bestPeak = peak;
+                    bestSum = sum;
+                    p = q;
+                }
+            }
+            // the child runs when its counter drops to 0
+            if (d > 1) l->delay_counter_ = (p + d - count_ % d) % d + 1;
+        }
+        else if (d > 1 && l->delay_counter_)
+        {
+            // the current phase, from the child's counter
+            p = (count_ + l->delay_counter_ - 1) % d;
+        }
+        l->phase_ = p;
+        for(uint t=p; t<H; t+=d) load[t] += it.weight;
+    }
+
+    cycleLoad_ = 0;
+    foreach(uint x, load) if (x > cycleLoad_) cycleLoad_ = x;
+}
+
+void QDaqLoop::registerTypes(QScriptEngine* e)
+{
+    qScriptRegisterOverrunPolicy(e);
+    qScriptRegisterBudgetAction(e);
+    QDaqJob::registerTypes(e);
+}
+
+void QDaqLoop::virtualRun()
+{
+    // wall clock for pacing at speed x real time
+    os::stopwatch wall;
+    wall.start();
+    double speed = speed_;
+    uint period = period_;
+    double n = 0; // cycles since the last change of speed or period
+
+    while (vcontinue_)
+    {
+        if (speed_ != speed || period_ != period)
+        {
+            speed = speed_;
+            period = period_;
+            wall.start();
+            n = 0;
+        }
+        if (speed > 0.)
+        {
+            double dt = 1.e-6*period_*n/speed - wall.sec();
+            if (dt > 0.) QThread::usleep((unsigned long)(1.e6*dt));
+        }
+
+        if (!timerCycle(-1,0)) break;
+
+        vtime_ += 1.e-6*period_;
+        n++;
+    }
+}
+
+int QDaqLoop::overrun(uint missed)
+{
+    missed_.fetchAndAddRelaxed(missed);
+    overruns_.fetchAndAddRelaxed(1);
+
+    if (overrunPolicy_==Abort)
+    {
+        pushError("Loop deadline missed",
+                  QString("%1 timer periods missed, loop aborted").arg(missed));
+        return -1;
+    }
+
+    // report at most once per second
+    missedUnreported_ += missed;
+    double t = clock_.sec();
+    if (t - tmissReport_ >= 1.)
+    {
+        pushError("Loop deadline missed",
+                  QString("%1 timer periods missed").arg(missedUnreported_));
+        tmissReport_ = t;
+        missedUnreported_ = 0;
+    }
+
+    return overrunPolicy_==CatchUp ? (int)missed : 0;
+}
+
+bool QDaqLoop::stage(QDaqJob* job, const char* name, const QVariant& value, bool isProperty)
+{
+    if (!running() || QThread::currentThreadId()==threadId_) return false;
+
+    Change* c = new Change;
+    c->job = job;
+    c->name = name;
+    c->value = value;
+    c->isProperty = isProperty;
+
+    // lock-free push
+    Change* head;
+    do {
+        head = staged_.loadAcquire();
+        c->next = head;
+    } while (!staged_.testAndSetOrdered(head,c));
+
+    return true;
+}
+
+bool QDaqLoop::applyStaged()
+{
+    Change* c = staged_.fetchAndStoreOrdered(0);
+    if (!c) return false;
+
+    // reverse to get the order of staging
+    Change* lst = 0;
+    while (c)
+    {
+        Change* n = c->next;
+        c->next = lst;
+        lst = c;
+        c = n;
+    }
+
+    // now on the loop thread the setters apply the values
+    while (lst)
+    {
+        Change* n = lst->next;
+        if (lst->job)
+        {
+            if (lst->isProperty) lst->job->setProperty(lst->name.constData(),lst->value);
+            else QMetaObject::invokeMethod(lst->job,lst->name.constData(),Qt::DirectConnection);
+        }
+        delete lst;
+        lst = n;
+    }
+    return true;
+}
+
+bool QDaqLoop::pause()
+{
+    if (!running() || QThread::currentThreadId()==threadId_) return false;
+
+    pauseRequests_.fetchAndAddOrdered(1);
+    QMutexLocker L(&pauseMtx_);
+    while (inCycle_.loadAcquire()) pauseCond_.wait(&pauseMtx_);
+    return true;
+}
+
+void QDaqLoop::resume()
+{
+    QMutexLocker L(&pauseMtx_);
+    if (pauseRequests_.fetchAndAddOrdered(-1)==1) pauseCond_.wakeAll();
+}
+
 void QDaqLoop::disarm_()
 {
     thread_.stop();
+    if (scheduled_)
+    {
+        QDaqScheduler::instance()->remove(this);
+        scheduled_ = false;
+    }
+    vcontinue_ = 0;
+    vthread_.wait();
+    applyStaged();
+    // misses suppressed by the rate limit
+    if (missedUnreported_)
+    {
+        pushError("Loop deadline missed",
+                  QString("%1 timer periods missed").arg(missedUnreported_));
+        missedUnreported_ = 0;
+    }
+    if (budgetUnreported_)
+    {
+        pushError("Budget exceeded",
+                  QString("%1 overruns not reported").arg(budgetUnreported_));
+        budgetUnreported_ = 0;
+    }
+    if (pool_)
+    {
+        delete pool_;
+        pool_ = 0;
+    }
+    plan_.clear();
     QDaqJob::disarm_();
 }
 
@@ -272,6 +1159,7 @@ void QDaqLoop::setLimit(uint d)
 {
     if (limit_ != d)
     {
+        if (stageProperty("limit",d)) return;
         // locked code
         {
             os::auto_lock L(comm_lock);
@@ -285,12 +1173,15 @@ void QDaqLoop::setDelay(uint d)
 {
     if (delay_ != d)
     {
+        if (stageProperty("delay",d)) return;
         // locked code
         {
             os::auto_lock L(comm_lock);
             delay_ = d;
             //counter_ = delay_;
         }
+        // the parent loop re-assigns the phases
+        invalidateSchedule();
         emit propertiesChanged();
     }
 }
@@ -304,35 +1195,320 @@ void QDaqLoop::setPreload(uint d)
     }
 }
 
-void QDaqLoop::setPeriod(unsigned int p)
+#ifdef _WIN32
+#define MIN_LOOP_PERIOD 1000 // us, resolution of the multimedia timer
+#else
+#define MIN_LOOP_PERIOD 100 // us
+#endif
+
+void QDaqLoop::setPeriod(double ms)
 {
-    if (p<10) p=10; // minimum 10 ms
+    uint p = ms*1000 < MIN_LOOP_PERIOD ? MIN_LOOP_PERIOD : (uint)(ms*1000 + 0.5);
     if (period_ != p)
     {
-        bool onlineChange = armed_;
-        if (onlineChange)
-        {
-            jobLock();
-            disarm_();
-        }
+        // a running loop changes period between cycles
+        if (stageProperty("period",ms)) return;
         period_ = p;
-        if (onlineChange)
-        {
-            arm_();
-            jobUnlock();
-        }
+        // the timer takes the new period after this cycle
+        if (thread_.is_running()) thread_.set_period(p);
+        if (scheduled_) QDaqScheduler::instance()->setPeriod(this,p);
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setRealTimePriority(int p)
+{
+    if (throwIfArmed()) return;
+    if (p<0 || p>99)
+    {
+        throwScriptError("Real-time priority must be in the range 0-99.");
+        return;
+    }
+    if (rtPriority_ != p)
+    {
+        rtPriority_ = p;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setCpuAffinity(int cpu)
+{
+    if (throwIfArmed()) return;
+    if (cpu<-1 || cpu>=QThread::idealThreadCount())
+    {
+        throwScriptError("Invalid cpu number.");
+        return;
+    }
+    if (cpuAffinity_ != cpu)
+    {
+        cpuAffinity_ = cpu;
         emit propertiesChanged();
     }
 }
 
+void QDaqLoop::setLockMemory(bool on)
+{
+    if (throwIfArmed()) return;
+    if (lockMemory_ != on)
+    {
+        lockMemory_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setParallel(bool on)
+{
+    if (throwIfArmed()) return;
+    if (parallel_ != on)
+    {
+        parallel_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setAutoPhase(bool on)
+{
+    if (autoPhase_ != on)
+    {
+        if (stageProperty("autoPhase",on)) return;
+        autoPhase_ = on;
+        scheduleDirty_.storeRelease(1);
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setFuseScripts(bool on)
+{
+    if (fuseScripts_ != on)
+    {
+        if (stageProperty("fuseScripts",on)) return;
+        fuseScripts_ = on;
+        scheduleDirty_.storeRelease(1);
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setExecPlan(bool on)
+{
+    if (execPlan_ != on)
+    {
+        if (stageProperty("execPlan",on)) return;
+        execPlan_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setThreads(uint n)
+{
+    if (throwIfArmed()) return;
+    if (threads_ != n)
+    {
+        threads_ = n;
+        emit propertiesChanged();
+    }
+}
+
+double QDaqLoop::skipRatio() const
+{
+    // keep the job tree still while reading
+    QDaqLoop* top = topLoop();
+    bool paused = top && top->pause();
+    uint computed = 0, skipped = 0;
+    changeStat(computed,skipped);
+    if (paused) top->resume();
+    uint n = computed + skipped;
+    return n ? 1.*skipped/n : 0.;
+}
+
 QString QDaqLoop::stat()
 {
+    // keep the job tree, the plan and the pool still while reading
+    QDaqLoop* top = topLoop();
+    bool paused = top && top->pause();
+    uint computed = 0, skipped = 0;
+    changeStat(computed,skipped);
     QString S("Loop statistics:");
-    S += QString("\n  Period (ms): %1").arg(perfmon[0]());
-    S += QString("\n  Load-time (ms): %2").arg(perfmon[1]());
+    S += QString("\n  Cycles recorded: %1").arg(hist_[PeriodHist].count());
+    if (isTop())
+        S += QString("\n  Missed timer periods: %1 in %2 overruns")
+                .arg(missedWakeups()).arg(overruns());
+    if (isTop())
+        S += QString("\n  Reconfigurations: %1, longest gap %2 ms")
+                .arg(reconfigurations_).arg(reconfigGap(),0,'f',3);
+    S += QString("\n  Worst-case cycle load: %1 jobs").arg(cycleLoad_);
+    if (budget_ || loopOverruns_)
+    {
+        QMutexLocker L(&budgetMtx_);
+        S += QString("\n  Budget overruns: %1").arg(loopOverruns_);
+        if (!overrunJob_.isEmpty()) S += QString(", last by %1").arg(overrunJob_);
+    }
+    if (isTop() && sharedTimer_)
+        S += QString("\n  Shared timer: %1 loops on %2 threads")
+                .arg(QDaqScheduler::instance()->loopCount())
+                .arg(QDaqScheduler::instance()->threadCount());
+    S += QString("\n  (ms)          p50       p99     p99.9       max");
+    const char* names[] = { "Period", "Latency", "Load-time" };
+    for(int i=0; i<3; ++i)
+    {
+        if (i==LatencyHist && !isTop()) continue;
+        QDaqVector v = histStats(i);
+        S += QString("\n  %1").arg(QString(names[i]),-10);
+        for(int j=0; j<v.size(); ++j) S += QString("%1").arg(v[j],10,'f',3);
+    }
+    S += QString("\n  Skipped computations: %1 of %2 (%3%)")
+            .arg(skipped).arg(computed + skipped).arg(100.*skipRatio(),0,'f',1);
+    S += QString("\n  Execution plan steps: %1").arg(plan_.size());
+    if (pool_)
+        S += QString("\n  Parallel: %1 threads, %2 of %3 jobs on any thread")
+                .arg(pool_->threadCount() + 1)
+                .arg(pool_->parallelJobs()).arg(subjobs_.size());
+    if (paused) top->resume();
+    return S;
+}
+
+QDaqVector QDaqLoop::histStats(int i) const
+{
+    const QDaqHistogram& h = hist_[i];
+    QDaqVector v(4);
+    v[0] = 1.e-6*h.percentile(50.);
+    v[1] = 1.e-6*h.percentile(99.);
+    v[2] = 1.e-6*h.percentile(99.9);
+    v[3] = 1.e-6*h.max();
+    return v;
+}
+
+void QDaqLoop::resetStats()
+{
+    for(int i=0; i<3; ++i) hist_[i].reset();
+    reconfigGap_ = 0.;
+    reconfigurations_ = 0;
+}
+
+void QDaqLoop::setOverrunPolicy(OverrunPolicy p)
+{
+    if ((int)p<Skip || (int)p>Abort)
+    {
+        throwScriptError("Invalid overrun policy. Available options: Skip, CatchUp, Abort.");
+        return;
+    }
+    if (overrunPolicy_ == p) return;
+    if (stageProperty("overrunPolicy",(int)p)) return;
+    overrunPolicy_ = p;
+    emit propertiesChanged();
+}
+
+void QDaqLoop::setBudgetAction(BudgetAction a)
+{
+    if ((int)a<LogOnly || (int)a>DisarmJob)
+    {
+        throwScriptError("Invalid budget action. Available options: LogOnly, SkipJob, DisarmJob.");
+        return;
+    }
+    if (budgetAction_ == a) return;
+    if (stageProperty("budgetAction",(int)a)) return;
+    budgetAction_ = a;
+    emit propertiesChanged();
+}
+
+void QDaqLoop::setBudgetSkip(uint n)
+{
+    if (budgetSkip_ == n) return;
+    if (stageProperty("budgetSkip",n)) return;
+    budgetSkip_ = n;
+    emit propertiesChanged();
+}
+
+void QDaqLoop::setVirtualClock(bool on)
+{
+    if (throwIfArmed()) return;
+    if (virtualClock_ != on)
+    {
+        virtualClock_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setSharedTimer(bool on)
+{
+    if (throwIfArmed()) return;
+    if (sharedTimer_ != on)
+    {
+        sharedTimer_ = on;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setSpeed(double s)
+{
+    if (s<0.)
+    {
+        throwScriptError("Speed must be >= 0.");
+        return;
+    }
+    if (speed_ != s)
+    {
+        // read by the virtual clock thread at each cycle
+        speed_ = s;
+        emit propertiesChanged();
+    }
+}
+
+void QDaqLoop::setStartTime(double t)
+{
+    if (throwIfArmed()) return;
+    if (startTime_ != t)
+    {
+        startTime_ = t;
+        emit propertiesChanged();
+    }
+}
+
+double QDaqLoop::time() const
+{
+    QDaqLoop* top = topLoop();
+    return top ? (double)top->clockTime() : (double)clockTime();
+}
+
+void QDaqLoop::setProfiling(bool on)
+{
+    if (profiling_ == on) return;
+
+    // profiles are created/deleted by the loop thread between cycles
+    if (stageProperty("profiling",on)) return;
+    profiling_ = on;
+    // a loop above may still profile the jobs
+    if (on || !profilingRequested()) setProfiled(on);
+    emit propertiesChanged();
+}
+
+QString QDaqLoop::profileReport()
+{
+    if (!prof_)
+    {
+        throwScriptError("Profiling is not enabled.");
+        return QString();
+    }
+    // keep the job tree still while reading
+    QDaqLoop* top = topLoop();
+    bool paused = top && top->pause();
+    qint64 total = profileTotal();
+    QString S = QString("Job profile of %1 (total %2 ms):\n")
+            .arg(objectName()).arg(1.e-6*total,0,'f',3);
+    S += QString("%1%2%3%4%5%6%7%8\n")
+            .arg(QString("Job"),-32).arg(QString("Calls"),10)
+            .arg(QString("Self(ms)"),12).arg(QString("Self%"),7).arg(QString("Total(ms)"),12)
+            .arg(QString("Mean(us)"),10).arg(QString("p99(us)"),10).arg(QString("Max(us)"),10);
+    QDaqJob::profileReport(S,0,total);
+    if (paused) top->resume();
     return S;
 }
 
+void QDaqLoop::resetProfile()
+{
+    if (stageCall("resetProfile")) return;
+    clearProfile();
+}
+
 void QDaqLoop::createLoopEngine()
 {
     if (throwIfArmed()) return;
@@ -2,13 +2,23 @@
 #define _RTJOB_H_
 
 #include "QDaqObject.h"
+#include "QDaqTypes.h"
 #include "math_util.h"
+#include "QDaqHistogram.h"
 
 #include <QPointer>
+#include <QVector>
+#include <QSet>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QWaitCondition>
 
 class QDaqScriptEngine;
 class QScriptProgram;
 class QDaqLoop;
+class QDaqJobPool;
+class QDaqWatchdog;
 
 /** Base class for objects that perform a specific task reqursively.
  *
@@ -35,10 +45,25 @@ job0
  will be executed with the following order:
  job0-job1-job11-job12-job2-job3
 
+The tree order is changed only when a job depends on the results of a job
+that comes later among its siblings (see dependencies()). When the parent
+is armed the sub-jobs are sorted so that each job runs after the jobs it depends on,
+otherwise keeping their original order.
+
 Before the job can perform its task it must be "armed".
 Arming does all the necessary initialization and is implemented in the function
 setArmed().
 
+While a loop is running its jobs are executed without locking.
+Property changes from other threads are queued and applied by the loop thread
+before the next cycle (see stageProperty()), so they take effect at a cycle boundary and
+the caller does not wait for the cycle to finish. Arming and disarming of jobs
+waits until the loop is between cycles.
+
+A job that blocks, e.g. a device read waiting for its timeout, delays all the
+jobs that follow. With a budget the job is watched by the QDaqWatchdog and,
+when it overruns, it is contained as set by QDaqLoop::budgetAction.
+
 */
 class QDAQ_EXPORT QDaqJob : public QDaqObject
 {
@@ -60,9 +85,30 @@ class QDAQ_EXPORT QDaqJob : public QDaqObject
      * The script code is executed by the top loop script engine,
      * which is obtained by loopEngine().
      *
+     * If the loop is running the new code is used from the next cycle.
+     *
      */
     Q_PROPERTY(QString code READ code WRITE setCode)
 
+    /** Time budget of the job per cycle in ms.
+     *
+     * If greater than 0, run() is expected to finish within this time.
+     * For a loop the budget refers to a whole cycle, including its sub-jobs.
+     *
+     * While the job runs the QDaqWatchdog reports an error as soon as the budget
+     * is exceeded. When the job returns the overrun is counted and the
+     * job is contained according to QDaqLoop::budgetAction of its loop.
+     *
+     * Default is 0 (no budget). Can be changed while the loop is running.
+     */
+    Q_PROPERTY(double budget READ budget WRITE setBudget)
+
+    /** Number of cycles in which the job exceeded its budget (read-only).
+     *
+     * It is reset when the job is armed.
+     */
+    Q_PROPERTY(uint budgetOverruns READ budgetOverruns)
+
 protected:
     // properties
     bool armed_;
@@ -73,6 +119,60 @@ protected:
     QPointer<QDaqScriptEngine> loop_eng_;
     // true if it is a loop
     bool isLoop_;
+    friend class QDaqLoop;
+    // change tracking: number of run() calls where the job had new input
+    // and did its work / where it had nothing new and skipped it
+    uint nComputed_, nSkipped_;
+
+    // Execution time statistics of run(), allocated while profiling (see QDaqLoop::profiling)
+    struct Profile
+    {
+        quint64 count;
+        qint64 total, max; // ns
+        QDaqCoarseHistogram hist;
+        Profile() : count(0), total(0), max(0) {}
+        void record(qint64 t)
+        {
+            count++;
+            total += t;
+            if (t>max) max = t;
+            hist.record(t);
+        }
+        void reset() { count = 0; total = max = 0; hist.reset(); }
+    };
+    Profile* prof_;
+
+    // time budget (ns) and start time of the current run() or loop cycle, 0 if idle
+    qint64 budget_;
+    volatile qint64 runStart_;
+    // cycles to skip after a budget overrun
+    uint skip_;
+    uint budgetOverruns_;
+    friend class QDaqWatchdog;
+    // called by the watchdog thread when the running job exceeds its budget
+    virtual void budgetStall(qint64 elapsed) const;
+
+    // run() timed by the profiler or the budget, if any
+    bool profiledRun()
+    {
+        if (!prof_ && !budget_) return run();
+        return timedRun();
+    }
+    bool timedRun();
+    // true if this job is a loop or under a loop with profiling enabled
+    bool profilingRequested() const;
+    // create/delete the profiles of this job and its child jobs
+    void setProfiled(bool on);
+    // clear the profiles of this job and its child jobs
+    void clearProfile();
+    // time (ns) spent in run() of this job and its child jobs
+    qint64 profileTotal() const;
+    // append profile lines of this job and its child jobs, ordered by self time
+    void profileReport(QString& S, int level, qint64 loopTotal) const;
+    static bool selfTimeGreater(const QPair<qint64, QDaqJob*>& a, const QPair<qint64, QDaqJob*>& b);
+
+    // number of armed jobs in my sub-tree, including me
+    uint jobCount() const;
 
 	/** Performs internal initialization for the job.
      *
@@ -91,6 +191,9 @@ protected:
      */
     virtual bool arm_();
 
+    // compile code_ into program_, replacing the previous one
+    bool compileCode();
+
     /** Performs internal de-initialization.
      *
      * It is called by the setArmed() function.
@@ -101,8 +204,78 @@ protected:
      */
     virtual void disarm_();
 
+    /** Append to lst the jobs whose results are used by this job.
+     *
+     * It is called after the job is armed and the result is used by the parent
+     * job to order its sub-jobs, so that each job runs after the jobs it depends on.
+     *
+     * The default implementation adds nothing. Subclasses reading data
+     * from other jobs (e.g. QDaqChannel with a parser expression) reimplement it.
+     *
+     */
+    virtual void dependencies(QList<QDaqJob*>& lst) const;
+
+    // dependencies() of this job and all armed descendants
+    void collectDependencies(QList<QDaqJob*>& lst) const;
+
+    // sum up change tracking statistics of this job and all sub-jobs
+    void changeStat(uint& computed, uint& skipped) const;
+
+    /** Add to reads and writes the objects accessed by run().
+     *
+     * It is used by a parallel QDaqLoop (see QDaqLoop::parallel) to find
+     * the sub-jobs that can run concurrently: two jobs are independent
+     * if none of them writes an object that the other one reads or writes.
+     *
+     * Return false if the accessed objects are not known. Such a job
+     * runs on the loop thread while no other job is running.
+     * The default implementation returns false if the job has script code,
+     * which may access anything, and true otherwise.
+     *
+     */
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
+
+    // dataAccess() of this job and all descendants.
+    // Returns false if some of them is unknown or not armed.
+    bool collectDataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
+
+    // mark the dependency graphs of the parallel loops above this job as outdated
+    void invalidateSchedule();
+
+    // sort again the sub-jobs of the armed ancestors, after the dependencies of
+    // this job changed. If apply is false, only check for circular dependencies.
+    bool sortParents(QString& cycle, bool apply);
+
+    /** Queue a property change while the top loop is running.
+     *
+     * Property setters that modify data used by run() call this function first.
+     * If the top loop is running and the caller is not the loop thread,
+     * the value is queued and true is returned; the setter should then return
+     * without changing anything. The loop thread writes the queued values
+     * in the order they were staged before starting its next cycle.
+     *
+     * Otherwise it returns false and the setter applies the value at once.
+     *
+     */
+    bool stageProperty(const char* name, const QVariant& value);
+    /// Same as stageProperty() for a slot without arguments.
+    bool stageCall(const char* slot);
+
+    // Keeps the top loop of a job between cycles while the job tree is modified.
+    // Does nothing when called from the loop thread or if the loop is not running.
+    friend class LoopPause;
+    class LoopPause
+    {
+        QDaqLoop* top_;
+    public:
+        LoopPause(const QDaqJob* j);
+        ~LoopPause();
+    };
+
 public:
 	bool armed() { return armed_; }
+    double budget() const { return 1.e-6*budget_; }
+    uint budgetOverruns() const { return budgetOverruns_; }
 
     /**
      * @brief Arms or disarms a job
@@ -122,9 +295,13 @@ public:
 
     const QString& code() const { return code_; }
     void setCode(const QString& s);
+    void setBudget(double ms);
 
 protected:
 
+    // executes sub-jobs of parallel loops
+    friend class QDaqJobPool;
+
     // a helper class to manage child-jobs
 	friend class JobList;
     class JobList : public QList<QDaqJob*>
@@ -137,8 +314,103 @@ protected:
             }
             void lock() { for(iterator i=begin(); i<end(); ++i) (*i)->jobLock(); }
             void unlock() { for(iterator i=end()-1; i>=begin(); --i) (*i)->jobUnlock(); }
+            // stable topological sort according to dependencies of the jobs under owner
+            bool sort(const QDaqJob* owner, QString& cycle);
 	};
 
+    // The job tree of a loop flattened in execution order.
+    // Each step runs one job; next is the step after the job's sub-tree,
+    // where execution continues if the job is not armed.
+    // Child loops are single steps, they execute their own plan.
+    // With fusion, adjacent script jobs are one step running a joined program.
+    friend class ExecPlan;
+    class ExecPlan
+    {
+        typedef bool (*step_fn)(QDaqJob*);
+        struct Step
+        {
+            step_fn fn; // 0 for jobs with nothing to run
+            QDaqJob* job;
+            int next;
+            int chunk; // index in chunks_, -1 for a single job
+        };
+        QVector<Step> steps_;
+
+        // the code of adjacent script jobs joined in one program
+        struct Chunk
+        {
+            QList<QDaqJob*> jobs;
+            // first line of each job's code
+            QVector<int> lines;
+            QScriptProgram* program;
+            QPointer<QDaqScriptEngine> engine;
+        };
+        QVector<Chunk*> chunks_;
+        bool fuse_;
+        // script jobs waiting to be fused
+        QList<QDaqJob*> run_;
+
+        static bool runJob(QDaqJob* j) { return j->profiledRun(); }
+        static bool execJob(QDaqJob* j) { return j->exec(); }
+        static bool runChunk(const Chunk* c);
+        static bool fusable(const QDaqJob* j);
+        void append(QDaqJob* j);
+        void appendStep(QDaqJob* j, step_fn fn, int chunk);
+        void flush();
+        ExecPlan(const ExecPlan&);
+        ExecPlan& operator=(const ExecPlan&);
+
+    public:
+        // the slowest step of a cycle
+        struct Longest
+        {
+            QDaqJob* job;
+            qint64 t; // ns
+            Longest() : job(0), t(0) {}
+        };
+
+        ExecPlan() : fuse_(false) {}
+        ~ExecPlan() { clear(); }
+
+        // fuse: join adjacent script jobs (see QDaqLoop::fuseScripts)
+        void build(const JobList& jobs, bool fuse = false);
+        void clear();
+        int size() const { return steps_.size(); }
+        // current is set to the running job, for the watchdog.
+        // If longest is given the steps are timed and the slowest is stored there.
+        bool exec(QDaqJob* volatile& current, Longest* longest = 0) const
+        {
+            const Step* s = steps_.constData();
+            int i = 0, n = steps_.size();
+            bool ret = true;
+            while (i<n)
+            {
+                const Step& st = s[i];
+                QDaqJob* j = st.job;
+                // a chunk checks each of its jobs
+                if (st.chunk<0)
+                {
+                    if (!j->armed_) { i = st.next; continue; }
+                    // skipped after a budget overrun, with its sub-jobs
+                    if (j->skip_) { j->skip_--; i = st.next; continue; }
+                    if (!st.fn) { i++; continue; }
+                }
+                current = j;
+                qint64 t = longest ? os::clock_ns() : 0;
+                ret = st.chunk<0 ? st.fn(j) : runChunk(chunks_[st.chunk]);
+                if (longest && (t = os::clock_ns() - t) > longest->t)
+                {
+                    longest->job = j;
+                    longest->t = t;
+                }
+                if (!ret) break;
+                i++;
+            }
+            current = 0;
+            return ret;
+        }
+    };
+
 	friend class JobLocker;
 	class JobLocker
 	{
@@ -163,7 +435,9 @@ protected:
      * and then the exec() of all sub-jobs.
      *
      * The function is called by the parent loop's
-     * QDaqLoop::exec() function.
+     * QDaqLoop::exec() function. A sequential loop runs its job tree
+     * from a flat execution plan, which calls run() of each armed job
+     * in the same order, so exec() is only called for child loops.
      *
      * @return false if run() return false or some child-job returns false; true otherwise.
      */
@@ -185,6 +459,10 @@ protected:
     // Throws script exception and error if called while the job is armed.
 	bool throwIfArmed();
 
+private slots:
+    // queued by the loop when budgetAction is DisarmJob
+    void budgetDisarm() { setArmed(false); }
+
 public:
     Q_INVOKABLE
     /**
@@ -270,13 +548,379 @@ class QDAQ_EXPORT QDaqLoop : public QDaqJob
 
     /** The repetition period in ms.
      * This is meaningful only for the top level loop.
+     *
+     * Fractional values give sub-millisecond periods, down to 0.1 ms (10 kHz)
+     * on Linux. On Windows the resolution and minimum is 1 ms.
+     *
+     * The signals updateWidgets() and propertiesChanged() are emitted at the
+     * GUI frame rate (see QDaqRoot::refreshRate), whatever the period.
+     *
+     * If the loop is running the new period starts at the next cycle,
+     * without restarting the timer thread.
+     */
+    Q_PROPERTY(double period READ period WRITE setPeriod)
+
+    /** Real-time priority of the loop thread.
+     *
+     * If greater than 0 the timer thread of a top level loop runs with
+     * the SCHED_FIFO policy at this priority (1-99). This needs the
+     * CAP_SYS_NICE capability or an rtprio limit; if it fails
+     * an error is reported and the loop runs with normal priority.
+     *
+     * On Windows any value > 0 selects THREAD_PRIORITY_TIME_CRITICAL.
+     *
+     * Default is 0 (normal scheduling). It can be changed only when the loop is disarmed.
+     */
+    Q_PROPERTY(int realTimePriority READ realTimePriority WRITE setRealTimePriority)
+
+    /** The CPU the loop thread is pinned to.
+     *
+     * If -1 (default) the thread may run on any CPU.
+     * Use together with an isolated core (isolcpus) for minimum jitter.
+     *
+     * It can be changed only when the loop is disarmed.
+     */
+    Q_PROPERTY(int cpuAffinity READ cpuAffinity WRITE setCpuAffinity)
+
+    /** Lock the process memory while the loop runs.
+     *
+     * If true, all current and future memory pages of the process are locked (mlockall)
+     * and the stack of the loop thread is pre-faulted when the loop is armed,
+     * so that the loop does not suffer page faults.
+     * The lock applies to the whole process; it is released (munlockall)
+     * when the last loop with lockMemory is disarmed.
+     *
+     * Default is false. It can be changed only when the loop is disarmed.
+     */
+    Q_PROPERTY(bool lockMemory READ lockMemory WRITE setLockMemory)
+
+    /** Fraction of channel/filter computations skipped (read-only).
+     *
+     * Channels and filters skip their work when their inputs have
+     * not changed since the last cycle.
+     * The ratio refers to all jobs under this loop since it was armed.
+     */
+    Q_PROPERTY(double skipRatio READ skipRatio)
+
+    /** Statistics of the loop period in ms (read-only).
+     *
+     * A vector with the median, the 99th and 99.9th percentiles
+     * and the maximum of the time between successive loop repetitions,
+     * recorded since the loop was armed or resetStats() was called.
+     * The values have a resolution of about 2%.
+     */
+    Q_PROPERTY(QDaqVector periodStats READ periodStats)
+
+    /** Statistics of the wake-up latency in ms (read-only).
+     *
+     * The delay between the nominal time of a timer tick and the
+     * start of the loop repetition, as [p50, p99, p99.9, max].
+     * Recorded only in a top level loop.
+     */
+    Q_PROPERTY(QDaqVector latencyStats READ latencyStats)
+
+    /** Statistics of the loop load-time in ms (read-only).
+     *
+     * The time to execute the loop and its child jobs,
+     * as [p50, p99, p99.9, max].
      */
-    Q_PROPERTY(uint period READ period WRITE setPeriod)
+    Q_PROPERTY(QDaqVector loadStats READ loadStats)
+
+    /** Measure the execution time of each job.
+     *
+     * If true, the run() function of this loop and of every job under it
+     * is timed and its count, total, maximum and time distribution are recorded.
+     * See profileReport(). When false the overhead is a pointer check per job.
+     *
+     * Can be changed while the loop is running.
+     * The default is false.
+     */
+    Q_PROPERTY(bool profiling READ profiling WRITE setProfiling)
+
+    /** What a top level loop does when it misses timer periods.
+     *
+     * When a cycle lasts longer than the period the following timer
+     * ticks are missed. The next cycle starts as soon as the previous ends and
+     * then, depending on the policy:
+     *   - Skip : the missed cycles are dropped (default)
+     *   - CatchUp : the missed cycles are executed back-to-back, so that
+     *     the number of cycles follows the elapsed time
+     *   - Abort : the loop aborts with an error
+     *
+     * Missed periods are also reported as "Loop deadline missed" errors,
+     * at most one per second.
+     */
+    Q_PROPERTY(OverrunPolicy overrunPolicy READ overrunPolicy WRITE setOverrunPolicy)
+
+    /** Number of timer periods missed since the loop was armed (read-only).
+     *
+     * Counted only in a top level loop.
+     */
+    Q_PROPERTY(uint missedWakeups READ missedWakeups)
+
+    /** Number of cycles that started late, after one or more
+     * missed timer periods, since the loop was armed (read-only).
+     */
+    Q_PROPERTY(uint overruns READ overruns)
+
+    /** Longest interval between cycles with a reconfiguration in between, in ms (read-only).
+     *
+     * Changes of a running loop, e.g. to period, code, delay or channel lists,
+     * are applied between cycles, and arming/disarming jobs keeps the loop between cycles.
+     * This is the longest loop period that included such a change, to be compared
+     * with period. It is reset by resetStats().
+     */
+    Q_PROPERTY(double reconfigGap READ reconfigGap)
+    /// Number of cycles preceded by a reconfiguration (read-only). It is reset by resetStats().
+    Q_PROPERTY(uint reconfigurations READ reconfigurations)
+
+    /** Run the loop on a virtual clock.
+     *
+     * If true, a top level loop does not wait for the system timer.
+     * The cycles are executed one after the other at the rate
+     * given by speed, and the loop time (see time) advances by period
+     * at each cycle. Clock channels record the loop time, so that recorded data
+     * (see QDaqDataPlayer) are processed as if acquired in real time.
+     *
+     * It can be changed only when the loop is disarmed. Default is false.
+     */
+    Q_PROPERTY(bool virtualClock READ virtualClock WRITE setVirtualClock)
+
+    /** Speed of the virtual clock relative to real time.
+     *
+     * With speed = N the virtual clock runs N times faster than real time.
+     * If 0 (default) the cycles run as fast as possible.
+     * Meaningful only when virtualClock is true.
+     */
+    Q_PROPERTY(double speed READ speed WRITE setSpeed)
+
+    /** Starting time of the virtual clock, in seconds since 1970-01-01 UTC.
+     *
+     * If 0 (default) the virtual clock starts at the system time of arming.
+     */
+    Q_PROPERTY(double startTime READ startTime WRITE setStartTime)
+
+    /** The current loop time in seconds since 1970-01-01 UTC (read-only).
+     *
+     * It is the time of the virtual clock or the system time.
+     */
+    Q_PROPERTY(double time READ time)
+
+    /** Run the loop on the shared timer.
+     *
+     * If true, a top level loop does not start its own timer thread.
+     * Its cycles are scheduled by the QDaqScheduler, which serves all such loops
+     * with one timer thread and a small pool of worker threads.
+     * Use it for many slow loops, e.g. monitoring or logging.
+     *
+     * The period is rounded to 1 ms and realTimePriority, cpuAffinity and lockMemory
+     * are ignored. Missed periods are handled according to overrunPolicy.
+     *
+     * It can be changed only when the loop is disarmed. Default is false.
+     */
+    Q_PROPERTY(bool sharedTimer READ sharedTimer WRITE setSharedTimer)
+
+    /** Execute independent sub-jobs concurrently.
+     *
+     * If true, the sub-jobs of the loop are run by a pool of threads
+     * together with the loop thread.
+     * Sub-jobs that access the same objects (see QDaqJob::dataAccess()),
+     * e.g. a channel and a filter reading it, still run one after the other in tree order.
+     * Jobs with script code run on the loop thread while no other job is running.
+     *
+     * Each sub-job is executed as a whole, including its own sub-jobs.
+     * A child loop that is disarmed when this loop is armed runs on the loop thread.
+     *
+     * It can be changed only when the loop is disarmed. Default is false.
+     */
+    Q_PROPERTY(bool parallel READ parallel WRITE setParallel)
+
+    /** Number of pool threads used when parallel is true.
+     *
+     * The loop thread executes jobs as well.
+     * If 0 (default) the number of CPU cores minus 1 is used.
+     *
+     * It can be changed only when the loop is disarmed.
+     */
+    Q_PROPERTY(uint threads READ threads WRITE setThreads)
+
+    /** Assign the phases of child loops automatically.
+     *
+     * If true, the child loops are run out of phase so that their load is spread
+     * evenly over the cycles of this loop. Their preload is ignored.
+     *
+     * The child loops are taken in rate-monotonic order, i.e., with increasing delay,
+     * and each one gets the phase that minimizes the peak load of the cycles
+     * where it runs. The load of a child loop is the number of armed jobs in its sub-tree.
+     *
+     * The phases are recomputed when child loops are armed or disarmed or their delay
+     * changes. Default is false.
+     */
+    Q_PROPERTY(bool autoPhase READ autoPhase WRITE setAutoPhase)
+
+    /** The cycle of the parent loop, modulo delay, in which this loop runs (read-only).
+     *
+     * It is given by preload or assigned by the parent loop if its autoPhase is set.
+     */
+    Q_PROPERTY(uint phase READ phase)
+
+    /** Worst-case load of a cycle (read-only).
+     *
+     * The maximum number of jobs that run in a single cycle of this loop,
+     * given the delay and phase of the child loops.
+     */
+    Q_PROPERTY(uint cycleLoad READ cycleLoad)
+
+    /** Run the code of adjacent script jobs as one script.
+     *
+     * If true, consecutive jobs in the execution order of this loop that are
+     * plain QDaqJob objects with code and without sub-jobs are joined into a single
+     * program. It is compiled when the job tree changes and evaluated with one call
+     * per cycle, at the position of the first job, so the order of execution
+     * relative to channels, filters and other jobs is the same as without fusion.
+     *
+     * This saves the overhead of a separate evaluation for each job,
+     * which dominates in loops with many small script jobs.
+     * Jobs with a budget and profiled jobs are not fused, so that they are timed.
+     * If one of the fused jobs is disarmed or skipped after a budget overrun,
+     * the jobs of its program are evaluated separately in that cycle.
+     * An error is reported by the job whose code failed, and the cycle stops
+     * there as without fusion. Not used in parallel loops.
+     *
+     * Default is false.
+     */
+    Q_PROPERTY(bool fuseScripts READ fuseScripts WRITE setFuseScripts)
+
+    /** Execute the job tree from the flat execution plan.
+     *
+     * If false, the sub-jobs are executed recursively, each job running its
+     * own sub-jobs, as in earlier versions. It is meant for comparing the two
+     * in benchmarks. fuseScripts needs the plan. Not used in parallel loops.
+     *
+     * Default is true.
+     */
+    Q_PROPERTY(bool execPlan READ execPlan WRITE setExecPlan)
+
+    /** What the loop does with a job that exceeds its budget (see QDaqJob::budget).
+     *
+     * It applies to the jobs of this loop that have a budget and, when the loop
+     * exceeds its own cycle budget, to the job that took longest in that cycle:
+     *   - LogOnly : the overrun is only reported (default)
+     *   - SkipJob : the job and its sub-jobs are skipped for the next budgetSkip cycles
+     *   - DisarmJob : the job is disarmed
+     *
+     * Overruns are reported as "Budget exceeded" errors, at most one per second.
+     * In a parallel loop the job that exceeded the cycle budget is not known,
+     * so the cycle overrun is only reported.
+     */
+    Q_PROPERTY(BudgetAction budgetAction READ budgetAction WRITE setBudgetAction)
+
+    /// Number of cycles a job is skipped when budgetAction is SkipJob. Default is 10.
+    Q_PROPERTY(uint budgetSkip READ budgetSkip WRITE setBudgetSkip)
+
+    /** Full name of the job that caused the last budget overrun in this loop (read-only).
+     *
+     * Empty if no job has been identified since the loop was armed.
+     */
+    Q_PROPERTY(QString overrunJob READ overrunJob)
+
+    Q_ENUMS(OverrunPolicy)
+    Q_ENUMS(BudgetAction)
+
+public:
+    /** Action on missed timer periods, see overrunPolicy.
+    */
+    enum OverrunPolicy {
+        Skip,    /**< Drop the missed cycles. */
+        CatchUp, /**< Run the missed cycles back-to-back. */
+        Abort    /**< Abort the loop with an error. */
+    };
+    /** Action on a job that exceeds its budget, see budgetAction.
+    */
+    enum BudgetAction {
+        LogOnly,  /**< Report the overrun. */
+        SkipJob,  /**< Skip the job for budgetSkip cycles. */
+        DisarmJob /**< Disarm the job. */
+    };
 
 protected:
-    uint count_, limit_, delay_, preload_,period_; // properties
+    uint count_, limit_, delay_, preload_,period_; // properties, period_ in us
     uint delay_counter_;
     bool aborted_;
+    bool parallel_;
+    uint threads_;
+    int rtPriority_, cpuAffinity_;
+    bool lockMemory_;
+    bool profiling_;
+
+    // overrun accounting, written by the timer thread
+    int overrunPolicy_;
+    QAtomicInt missed_, overruns_;
+    // time of the last deadline-miss report (s) and periods missed since then
+    double tmissReport_;
+    uint missedUnreported_;
+    // called by the timer thread after missed periods,
+    // returns the number of extra cycles to run or -1 to abort
+    int overrun(uint missed);
+
+    // virtual clock
+    bool virtualClock_;
+    double speed_, startTime_;
+    double vtime_; // current virtual time (s)
+    // the thread running the cycles in virtual time
+    struct VirtualRunner
+    {
+        QDaqLoop* loop;
+        void operator()() { loop->virtualRun(); }
+    };
+    friend struct VirtualRunner;
+    VirtualRunner vrunner_;
+    os::thread<VirtualRunner> vthread_;
+    volatile int vcontinue_;
+    void virtualRun();
+    // shared timer
+    bool sharedTimer_;
+    volatile bool scheduled_; // registered with the QDaqScheduler
+    friend class QDaqScheduler;
+    // true while the loop is driven by the timer, the virtual clock thread or the scheduler
+    bool running() const { return thread_.is_running() || vthread_.is_running() || scheduled_; }
+
+    // thread pool and dependency graph for parallel execution
+    friend class QDaqJob;
+    QDaqJobPool* pool_;
+    // compiled job tree for sequential execution
+    ExecPlan plan_;
+    // set when the plan / graph must be rebuilt
+    QAtomicInt scheduleDirty_;
+    // rebuild the plan / graph after a change of the job tree
+    void rebuildSchedule();
+
+    // phase balancing of child loops
+    bool autoPhase_;
+    uint phase_, cycleLoad_;
+    // assign the phases of the child loops, relative to the current count
+    void balancePhases();
+
+    // join adjacent script jobs in the plan
+    bool fuseScripts_;
+    // run from plan_, else recursively
+    bool execPlan_;
+
+    // budget overruns
+    int budgetAction_;
+    uint budgetSkip_;
+    // the job running in the plan, read by the watchdog
+    QDaqJob* volatile current_;
+    // full name of the last job that overran and number of overruns, under budgetMtx_
+    QMutex budgetMtx_;
+    QString overrunJob_;
+    uint loopOverruns_;
+    // time of the last overrun report (s) and overruns since then
+    double tbudgetReport_;
+    uint budgetUnreported_;
+    // report an overrun and apply budgetAction to the job (if known)
+    void containOverrun(QDaqJob* j, const QString& msg);
+    virtual void budgetStall(qint64 elapsed) const;
 
     /**
      * @brief Called when a loop is executed.
@@ -288,13 +932,17 @@ protected:
      * according to the order of the child-loop in the
      * tree structure.
      *
-     * This function first locks the mutexes of all child jobs
-     * to prevent access from other threads. Then it calls
-     * QDaqJob::exec() which runs all child jobs. Finally it unlocks
-     * the mutexes in the reverse order as they were locked.
+     * This function runs all child jobs
+     * in the order of QDaqJob::exec(), using a flat execution plan
+     * of the job tree that is compiled when the loop is armed and
+     * rebuilt when a job is armed/disarmed or its code changes.
+     * No locks are taken: changes from other threads are applied
+     * by the top level loop between cycles.
+     *
+     * In a parallel loop the child jobs are passed to the thread pool.
      *
      * The signals updateWidgets() and propertiesChanged()
-     * are emitted at each valid repetition.
+     * are requested at valid repetitions with notifyGui().
      *
      * @return
      */
@@ -308,29 +956,117 @@ protected:
     timer_t thread_;
 
     // the () operator is defined for the timer thread
-    bool operator()() { return exec(); }
+    bool operator()() { return timerCycle(thread_.latency(), thread_.last_missed()); }
+
+    // Reconfiguration at cycle boundaries (top level loop).
+    // Property changes staged by other threads, most recent first
+    struct Change
+    {
+        QPointer<QDaqJob> job;
+        QByteArray name;
+        QVariant value;
+        bool isProperty;
+        Change* next;
+    };
+    QAtomicPointer<Change> staged_;
+    // inCycle_ is set while the timer thread runs a cycle;
+    // pauseRequests_ counts threads waiting to modify the job tree
+    QAtomicInt inCycle_, pauseRequests_;
+    QMutex pauseMtx_;
+    QWaitCondition pauseCond_;
+    Qt::HANDLE threadId_;
+
+    friend class QDaqJob::LoopPause;
+    // called by the timer thread: apply changes, then exec()
+    // latency (ns, <0 if unknown) and missed periods are given by the caller
+    bool timerCycle(qint64 latency, uint missed);
+    // queue a change, returns false if it must be applied directly
+    bool stage(QDaqJob* job, const char* name, const QVariant& value, bool isProperty);
+    // apply all queued changes, returns false if there were none
+    bool applyStaged();
+    // reconfiguration before the current cycle, longest gap (s) and count
+    bool reconfigured_;
+    double reconfigGap_;
+    uint reconfigurations_;
+    // wait for the end of the current cycle and keep the loop from starting another
+    bool pause();
+    void resume();
 
     // Loop performance monitors
-    // perfmon[0] : average loop period (ms)
-    // perfmon[1] : average loop load-time (ms)
-    typedef math::running_average<float,10> perfmon_t;
-    perfmon_t perfmon[2];
+    // hist_[0] : loop period
+    // hist_[1] : wake-up latency of the timer thread
+    // hist_[2] : loop load-time
+    enum { PeriodHist, LatencyHist, LoadHist };
+    QDaqHistogram hist_[3];
+    QDaqVector histStats(int i) const;
     os::stopwatch clock_;
-    float t_[2];
+    double t_[2];
 
 public:
     Q_INVOKABLE explicit QDaqLoop(const QString& name);
     virtual ~QDaqLoop(void);
 
+    virtual void registerTypes(QScriptEngine* e);
+
     uint limit() const { return limit_; }
     uint count() const { return count_; }
     uint delay() const { return delay_; }
     uint preload() const { return preload_; }
-    uint period() const { return period_; }
+    double period() const { return 0.001*period_; }
+    int realTimePriority() const { return rtPriority_; }
+    int cpuAffinity() const { return cpuAffinity_; }
+    bool lockMemory() const { return lockMemory_; }
+    double skipRatio() const;
+    QDaqVector periodStats() const { return histStats(PeriodHist); }
+    QDaqVector latencyStats() const { return histStats(LatencyHist); }
+    QDaqVector loadStats() const { return histStats(LoadHist); }
+    bool parallel() const { return parallel_; }
+    uint threads() const { return threads_; }
+    bool autoPhase() const { return autoPhase_; }
+    bool fuseScripts() const { return fuseScripts_; }
+    bool execPlan() const { return execPlan_; }
+    uint phase() const { return phase_; }
+    uint cycleLoad() const { return cycleLoad_; }
+    bool profiling() const { return profiling_; }
+    OverrunPolicy overrunPolicy() const { return (OverrunPolicy)overrunPolicy_; }
+    uint missedWakeups() const { return missed_.load(); }
+    uint overruns() const { return overruns_.load(); }
+    double reconfigGap() const { return 1000.*reconfigGap_; }
+    uint reconfigurations() const { return reconfigurations_; }
+    BudgetAction budgetAction() const { return (BudgetAction)budgetAction_; }
+    uint budgetSkip() const { return budgetSkip_; }
+    QString overrunJob();
+    bool virtualClock() const { return virtualClock_; }
+    double speed() const { return speed_; }
+    double startTime() const { return startTime_; }
+    double time() const;
+    bool sharedTimer() const { return sharedTimer_; }
     void setLimit(uint d);
     void setDelay(uint d);
     void setPreload(uint d);
-    void setPeriod(uint p);
+    void setPeriod(double p);
+    void setRealTimePriority(int p);
+    void setCpuAffinity(int cpu);
+    void setLockMemory(bool on);
+    void setParallel(bool on);
+    void setThreads(uint n);
+    void setAutoPhase(bool on);
+    void setFuseScripts(bool on);
+    void setExecPlan(bool on);
+    void setProfiling(bool on);
+    void setOverrunPolicy(OverrunPolicy p);
+    void setBudgetAction(BudgetAction a);
+    void setBudgetSkip(uint n);
+    void setVirtualClock(bool on);
+    void setSpeed(double s);
+    void setStartTime(double t);
+    void setSharedTimer(bool on);
+
+    /// Time of this top level loop: virtual or system time
+    QDaqTimeValue clockTime() const
+    {
+        return virtualClock_ ? QDaqTimeValue(vtime_) : QDaqTimeValue::now();
+    }
 
     /// Return true if this is a top level loop
     bool isTop() const { return this==topLoop(); }
@@ -365,6 +1101,25 @@ public slots:
     /// Print loop statistics.
     QString stat();
 
+    /// Clear the period, latency and load-time statistics.
+    void resetStats();
+
+    /**
+     * @brief Print the job profile of the loop.
+     *
+     * The report has the same tree structure as objectTree().
+     * For each job it lists the number of calls, the self time (spent in run()
+     * of the job) and its fraction of the loop total, the total time including
+     * the sub-jobs and the mean, 99th percentile and maximum self time per call.
+     * Siblings are sorted by self time, largest first.
+     *
+     * The profiling property must be enabled.
+     */
+    QString profileReport();
+
+    /// Clear the job profile of the loop.
+    void resetProfile();
+
     /**
      * @brief Create a dedicated QDaqScriptEngine.
      *
@@ -0,0 +1,60 @@
+#ifndef QDAQJOBPLUGIN_H
+#define QDAQJOBPLUGIN_H
+
+#include <QtPlugin>
+
+/// An input channel as seen by a QDaqJobPlugin at each cycle
+struct QDaqJobInput
+{
+    double value;  ///< current value of the channel
+    double std;    ///< standard deviation of the value
+    bool updated;  ///< true if the channel was updated since the previous cycle
+};
+
+/// An output channel written by a QDaqJobPlugin
+struct QDaqJobOutput
+{
+    double value;  ///< value to push to the channel
+    bool push;     ///< true on entry; set false to leave the channel unchanged in this cycle
+};
+
+/**
+ * @brief Interface of native job plugins.
+ *
+ * A job plugin implements per-cycle logic in compiled code. It is loaded
+ * by a QDaqNativeJob, which binds it to input and output channels and calls
+ * run() at each loop cycle without going through the script engine.
+ *
+ */
+class QDaqJobPlugin
+{
+public:
+    virtual ~QDaqJobPlugin() {}
+
+    virtual QString errorMsg() = 0;
+
+    /**
+     * @brief Return false if the number of channels is not supported.
+     *
+     * It is called before init() when the channels of an armed job change,
+     * possibly while run() executes in the loop thread, so it must not
+     * modify the plugin. The default accepts any number.
+     */
+    virtual bool accepts(int nInputs, int nOutputs) const
+    {
+        Q_UNUSED(nInputs);
+        Q_UNUSED(nOutputs);
+        return true;
+    }
+    /// Called when the job is armed. Return false if the number of channels is not supported.
+    virtual bool init(int nInputs, int nOutputs) = 0;
+    /// Called at each cycle with one element per bound channel. Return false to abort the loop.
+    virtual bool run(const QDaqJobInput* in, QDaqJobOutput* out) = 0;
+};
+
+/// An identifier to be used in IID metadata of job plugins
+#define QDaqJobPlugin_iid "org.qdaq.jobplugin"
+
+Q_DECLARE_INTERFACE(QDaqJobPlugin, QDaqJobPlugin_iid)
+
+#endif // QDAQJOBPLUGIN_H
@@ -0,0 +1,199 @@
+#include "QDaqJobPool.h"
+#include "QDaqJob.h"
+
+#include <QSet>
+
+QDaqJobPool::QDaqJobPool(int nthreads) :
+    nParallel_(0), cycle_(0), quit_(false)
+{
+    queues_ << new Queue;
+    for(int i=1; i<=nthreads; ++i)
+    {
+        Worker* w = new Worker;
+        w->pool = this;
+        w->id = queues_.size();
+        queues_ << new Queue;
+        if (w->thread_.start(w)) workers_ << w;
+        else
+        {
+            delete queues_.takeLast();
+            delete w;
+            break;
+        }
+    }
+}
+QDaqJobPool::~QDaqJobPool()
+{
+    {
+        QMutexLocker L(&mtx_);
+        quit_ = true;
+        startCond_.wakeAll();
+    }
+    foreach(Worker* w, workers_)
+    {
+        w->thread_.wait();
+        delete w;
+    }
+    qDeleteAll(queues_);
+}
+void QDaqJobPool::setJobs(const QList<QDaqJob*>& jobs)
+{
+    int n = jobs.size();
+    jobs_ = jobs.toVector();
+    succ_ = QVector< QVector<int> >(n);
+    npred_.fill(0,n);
+    serial_.fill(false,n);
+    pending_.resize(n);
+    nParallel_ = 0;
+
+    QVector< QSet<const QDaqObject*> > reads(n), writes(n);
+    for(int i=0; i<n; ++i)
+    {
+        serial_[i] = !jobs_[i]->collectDataAccess(reads[i],writes[i]);
+        if (!serial_[i]) nParallel_++;
+    }
+
+    // job i waits for an earlier job j if one of them writes
+    // what the other one accesses
+    for(int i=0; i<n; ++i)
+        for(int j=0; j<i; ++j)
+        {
+            if (serial_[i] || serial_[j] ||
+                    writes[j].intersects(reads[i]) ||
+                    writes[j].intersects(writes[i]) ||
+                    reads[j].intersects(writes[i]))
+            {
+                succ_[j] << i;
+                npred_[i]++;
+            }
+        }
+}
+bool QDaqJobPool::exec()
+{
+    int n = jobs_.size();
+    if (!n) return true;
+
+    for(int i=0; i<n; ++i) pending_[i].storeRelease(npred_[i]);
+    failed_.storeRelease(0);
+    remaining_.storeRelease(n);
+
+    // distribute the jobs that can start to all queues
+    int k = 0;
+    for(int i=0; i<n; ++i)
+        if (!npred_[i]) push(i, serial_[i] ? 0 : (k++ % queues_.size()));
+
+    {
+        QMutexLocker L(&mtx_);
+        cycle_++;
+        startCond_.wakeAll();
+    }
+
+    work(0);
+
+    return !failed_.loadAcquire();
+}
+void QDaqJobPool::workerLoop(int id)
+{
+    int cycle = 0;
+    forever
+    {
+        {
+            QMutexLocker L(&mtx_);
+            while (!quit_ && cycle==cycle_) startCond_.wait(&mtx_);
+            if (quit_) return;
+            cycle = cycle_;
+        }
+        work(id);
+    }
+}
+void QDaqJobPool::work(int id)
+{
+    while (remaining_.loadAcquire())
+    {
+        int t = take(id);
+        if (t>=0) execute(t,id);
+        else wait(id);
+    }
+}
+int QDaqJobPool::take(int id)
+{
+    int t = -1;
+
+    // serial jobs run only on the calling thread
+    if (id==0 && serialReady_.loadAcquire() && (t = serialQueue_.pop())>=0)
+    {
+        serialReady_.fetchAndAddOrdered(-1);
+        return t;
+    }
+
+    if (!ready_.loadAcquire()) return -1;
+
+    // first my own queue, then steal from the others
+    t = queues_[id]->pop();
+    int nq = queues_.size();
+    for(int i=1; t<0 && i<nq; ++i) t = queues_[(id+i) % nq]->steal();
+
+    if (t>=0) ready_.fetchAndAddOrdered(-1);
+    return t;
+}
+void QDaqJobPool::execute(int t, int id)
+{
+    // after a failure the remaining jobs are only counted down
+    if (!failed_.loadAcquire())
+    {
+        if (!jobs_[t]->exec()) failed_.storeRelease(1);
+    }
+
+    foreach(int s, succ_[t])
+        if (pending_[s].fetchAndAddOrdered(-1)==1) push(s,id);
+
+    if (remaining_.fetchAndAddOrdered(-1)==1) wakeIdle();
+}
+void QDaqJobPool::push(int t, int id)
+{
+    if (serial_[t])
+    {
+        serialQueue_.push(t);
+        serialReady_.fetchAndAddOrdered(1);
+    }
+    else
+    {
+        queues_[id]->push(t);
+        ready_.fetchAndAddOrdered(1);
+    }
+    wakeIdle();
+}
+void QDaqJobPool::wait(int id)
+{
+    // idle_ is raised before checking for work and the producers
+    // check idle_ after publishing work, so no wake-up is lost
+    QMutexLocker L(&mtx_);
+    idle_.fetchAndAddOrdered(1);
+    if (remaining_.loadAcquire() && !ready_.loadAcquire() &&
+            !(id==0 && serialReady_.loadAcquire()))
+        workCond_.wait(&mtx_);
+    idle_.fetchAndAddOrdered(-1);
+}
+void QDaqJobPool::wakeIdle()
+{
+    if (idle_.loadAcquire())
+    {
+        QMutexLocker L(&mtx_);
+        workCond_.wakeAll();
+    }
+}
+void QDaqJobPool::Queue::push(int t)
+{
+    QMutexLocker L(&mtx);
+    items.append(t);
+}
+int QDaqJobPool::Queue::pop()
+{
+    QMutexLocker L(&mtx);
+    return items.isEmpty() ? -1 : items.takeLast();
+}
+int QDaqJobPool::Queue::steal()
+{
+    QMutexLocker L(&mtx);
+    return items.isEmpty() ? -1 : items.takeFirst();
+}
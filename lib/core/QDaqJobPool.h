@@ -0,0 +1,106 @@
+#ifndef QDAQJOBPOOL_H
+#define QDAQJOBPOOL_H
+
+#include "os_utils.h"
+
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+class QDaqJob;
+
+/**
+ * @brief A work-stealing thread pool that executes the sub-jobs of a parallel QDaqLoop.
+ *
+ * @ingroup Core
+ *
+ * The sub-jobs passed to setJobs() form a dependency graph: a job must run after
+ * an earlier sibling when one of them writes an object that the other accesses
+ * (see QDaqJob::dataAccess()). Jobs without such a relation may run concurrently.
+ *
+ * At each call to exec() the jobs without predecessors are distributed to the
+ * queues of the pool threads and of the calling (loop) thread. Each thread takes jobs
+ * from the back of its own queue and, when it is empty, steals from the front of
+ * the other queues. When a job finishes its successors that became ready are
+ * pushed to the queue of the thread that ran it. exec() returns when all jobs
+ * have finished.
+ *
+ * Jobs with unknown data access (e.g. running script code) are always
+ * executed by the calling thread and after/before all other jobs.
+ *
+ */
+class QDaqJobPool
+{
+public:
+    /// Create a pool with nthreads threads in addition to the calling thread.
+    explicit QDaqJobPool(int nthreads);
+    ~QDaqJobPool();
+
+    /// Build the dependency graph of the jobs, given in their sequential execution order.
+    void setJobs(const QList<QDaqJob*>& jobs);
+
+    /// Execute all jobs once. Returns false if some job failed.
+    bool exec();
+
+    /// Number of pool threads (not counting the calling thread).
+    int threadCount() const { return workers_.size(); }
+    /// Number of jobs with known data access, which can run on any thread.
+    int parallelJobs() const { return nParallel_; }
+
+private:
+    // a double ended queue of ready jobs
+    struct Queue
+    {
+        QMutex mtx;
+        QList<int> items;
+        void push(int t);
+        int pop();   // from the back, by the owner
+        int steal(); // from the front, by other threads
+    };
+
+    // a pool thread
+    struct Worker
+    {
+        QDaqJobPool* pool;
+        int id;
+        os::thread<Worker> thread_;
+        void operator()() { pool->workerLoop(id); }
+    };
+    friend struct Worker;
+
+    // the job graph
+    QVector<QDaqJob*> jobs_;
+    QVector< QVector<int> > succ_; // jobs that wait for job i
+    QVector<int> npred_;           // number of jobs that job i waits for
+    QVector<bool> serial_;         // job i must run on the calling thread
+    QVector<QAtomicInt> pending_;  // unfinished predecessors in the current cycle
+    int nParallel_;
+
+    // queues[0] belongs to the calling thread, queues[i] to workers_[i-1]
+    QVector<Queue*> queues_;
+    Queue serialQueue_;
+    QList<Worker*> workers_;
+
+    QAtomicInt remaining_; // unfinished jobs in the current cycle
+    QAtomicInt ready_;     // jobs in queues_
+    QAtomicInt serialReady_; // jobs in serialQueue_
+    QAtomicInt idle_;      // threads waiting for work
+    QAtomicInt failed_;
+
+    QMutex mtx_;
+    QWaitCondition startCond_, workCond_;
+    int cycle_;
+    bool quit_;
+
+    void workerLoop(int id);
+    void work(int id);
+    int take(int id);
+    void execute(int t, int id);
+    void push(int t, int id);
+    void wait(int id);
+    void wakeIdle();
+};
+
+#endif // QDAQJOBPOOL_H
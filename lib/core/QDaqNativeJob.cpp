@@ -0,0 +1,234 @@
+#include "QDaqNativeJob.h"
+#include "QDaqChannel.h"
+#include "qdaqpluginloader.h"
+
+QDaqNativeJob::QDaqNativeJob(const QString& name) : QDaqJob(name),
+    plugin_(0), pending_(false)
+{
+
+}
+
+// getters
+QDaqObjectList QDaqNativeJob::inputChannels() const
+{
+    QDaqObjectList lst;
+    for(int i=0; i<inputChannels_.size(); i++)
+        lst.append(inputChannels_[i]);
+    return lst;
+}
+QDaqObjectList QDaqNativeJob::outputChannels() const
+{
+    QDaqObjectList lst;
+    for(int i=0; i<outputChannels_.size(); i++)
+        lst.append(outputChannels_[i]);
+    return lst;
+}
+
+// setters
+bool QDaqNativeJob::toChannels(const QDaqObjectList& lst, channel_vector_t& v)
+{
+    // check if we have valid QDaqChannels
+    v.clear();
+    for(int i=0; i<lst.size(); i++)
+    {
+        QDaqChannel* ch = qobject_cast<QDaqChannel*>(lst.at(i));
+        if (!ch)
+        {
+            throwScriptError(QString("%1 is not a channel.").arg(lst.at(i)->objectName()));
+            return false;
+        }
+        v.push_back(ch);
+    }
+    return true;
+}
+void QDaqNativeJob::setInputChannels(QDaqObjectList lst)
+{
+    channel_vector_t v;
+    if (!toChannels(lst,v)) return;
+    if (armed_ && v.size() != inputChannels_.size())
+    {
+        throwScriptError("Incorrect number of input channels, use setChannels() to change it.");
+        return;
+    }
+    if (stageProperty("inputChannels",QVariant::fromValue(lst))) return;
+
+    {
+        os::auto_lock L(comm_lock);
+        inputChannels_ = v;
+        // the new inputs count as updated
+        if (armed_) inputUpdates_.fill(0,v.size());
+    }
+    if (armed_) invalidateSchedule();
+}
+void QDaqNativeJob::setOutputChannels(QDaqObjectList lst)
+{
+    channel_vector_t v;
+    if (!toChannels(lst,v)) return;
+    if (armed_ && v.size() != outputChannels_.size())
+    {
+        throwScriptError("Incorrect number of output channels, use setChannels() to change it.");
+        return;
+    }
+    if (stageProperty("outputChannels",QVariant::fromValue(lst))) return;
+
+    {
+        os::auto_lock L(comm_lock);
+        outputChannels_ = v;
+    }
+    if (armed_) invalidateSchedule();
+}
+void QDaqNativeJob::setChannels(QDaqObjectList in, QDaqObjectList out)
+{
+    channel_vector_t vin, vout;
+    if (!toChannels(in,vin) || !toChannels(out,vout)) return;
+    if (armed_ && plugin_ && !plugin_->accepts(vin.size(),vout.size()))
+    {
+        throwScriptError(QString("The job plugin does not accept %1 inputs and %2 outputs.")
+                         .arg(vin.size()).arg(vout.size()));
+        return;
+    }
+
+    {
+        os::auto_lock L(comm_lock);
+        pendingIn_ = vin;
+        pendingOut_ = vout;
+        pending_ = true;
+    }
+    if (stageCall("applyChannels")) return;
+    applyChannels();
+}
+void QDaqNativeJob::applyChannels()
+{
+    {
+        os::auto_lock L(comm_lock);
+        if (!pending_) return;
+        pending_ = false;
+        if (armed_ && !rebind(pendingIn_,pendingOut_)) return;
+        inputChannels_ = pendingIn_;
+        outputChannels_ = pendingOut_;
+    }
+    if (armed_) invalidateSchedule();
+    emit propertiesChanged();
+}
+
+bool QDaqNativeJob::rebind(const channel_vector_t& in, const channel_vector_t& out)
+{
+    if (in.size() != in_.size() || out.size() != out_.size())
+    {
+        if (!plugin_->init(in.size(),out.size()))
+        {
+            // this runs between loop cycles, report to the error log
+            pushError("Job plugin initialization failed",plugin_->errorMsg());
+            // keep the previous channels
+            plugin_->init(in_.size(),out_.size());
+            return false;
+        }
+        setupBuffers(in.size(),out.size());
+    }
+    else inputUpdates_.fill(0,in.size());
+    return true;
+}
+
+void QDaqNativeJob::setupBuffers(int nin, int nout)
+{
+    in_.resize(nin);
+    out_.resize(nout);
+    for(int i=0; i<out_.size(); i++)
+    {
+        out_[i].value = 0.;
+        out_[i].push = true;
+    }
+    inputUpdates_.fill(0,nin);
+}
+
+QStringList QDaqNativeJob::listPlugins()
+{
+    return QDaqPluginLoader<QDaqJobPlugin*>::findPlugins();
+}
+
+bool QDaqNativeJob::loadPlugin(const QString &fname)
+{
+    if (throwIfArmed()) return false;
+
+    QObject *plugin = QDaqPluginLoader<QDaqJobPlugin*>::loadPlugin(fname);
+
+    if (plugin) {
+        QDaqJobPlugin* ijob = qobject_cast<QDaqJobPlugin*>(plugin);
+        if (ijob) {
+            plugin_ = ijob;
+            plugin->setParent(this);
+        }
+    }
+    return plugin_!=0;
+}
+
+bool QDaqNativeJob::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    writes << this;
+    for(int i=0; i<inputChannels_.size(); i++)
+        if (inputChannels_[i]) reads << inputChannels_[i].data();
+    for(int i=0; i<outputChannels_.size(); i++)
+        if (outputChannels_[i]) writes << outputChannels_[i].data();
+    return QDaqJob::dataAccess(reads,writes);
+}
+
+bool QDaqNativeJob::run()
+{
+    // get input values
+    for(int i=0; i<inputChannels_.size(); i++)
+    {
+        QDaqChannel* ch = inputChannels_[i];
+        if (!ch)
+        {
+            pushError("Input channel lost.");
+            return false;
+        }
+        QDaqJobInput& v = in_[i];
+        v.value = ch->value();
+        v.std = ch->std();
+        v.updated = ch->updateCount() != inputUpdates_[i];
+        inputUpdates_[i] = ch->updateCount();
+    }
+
+    for(int i=0; i<out_.size(); i++) out_[i].push = true;
+
+    nComputed_++;
+    if (!plugin_->run(in_.constData(), out_.data()))
+    {
+        pushError("Job plugin failed",plugin_->errorMsg());
+        return false;
+    }
+
+    // push output values
+    for(int i=0; i<outputChannels_.size(); i++)
+    {
+        QDaqChannel* ch = outputChannels_[i];
+        if (!ch)
+        {
+            pushError("Output channel lost.");
+            return false;
+        }
+        if (out_[i].push) ch->push(out_[i].value);
+    }
+
+    return QDaqJob::run();
+}
+
+bool QDaqNativeJob::arm_()
+{
+    if (!plugin_)
+    {
+        throwScriptError("No job plugin loaded.");
+        return false;
+    }
+
+    if (!plugin_->init(inputChannels_.size(),outputChannels_.size()))
+    {
+        throwScriptError(QString("Job plugin initialization failed: %1").arg(plugin_->errorMsg()));
+        return false;
+    }
+
+    setupBuffers(inputChannels_.size(),outputChannels_.size());
+
+    return QDaqJob::arm_();
+}
@@ -0,0 +1,105 @@
+#ifndef QDAQNATIVEJOB_H
+#define QDAQNATIVEJOB_H
+
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+
+#include "QDaqJobPlugin.h"
+
+#include <QPointer>
+
+class QDaqChannel;
+
+/**
+ * @brief A job that runs a native QDaqJobPlugin.
+ *
+ * @ingroup Core
+ *
+ * The plugin is loaded with loadPlugin() and bound to the channels
+ * in inputChannels and outputChannels.
+ * At each cycle the values of the input channels are passed to
+ * QDaqJobPlugin::run() and the values it returns are pushed to the output channels.
+ *
+ * Use it instead of the code property for logic that runs at high rates:
+ * the plugin is called directly, while script code is evaluated by the
+ * loop script engine.
+ *
+ */
+class QDAQ_EXPORT QDaqNativeJob : public QDaqJob
+{
+    Q_OBJECT
+
+    /** A QList of the input channels for this job.
+     *
+     * If the job is armed the change is applied between loop cycles and the
+     * number of channels must stay the same. Use setChannels() to change it.
+     */
+    Q_PROPERTY(QDaqObjectList inputChannels READ inputChannels WRITE setInputChannels)
+    /// A QList of the output channels for this job, see inputChannels.
+    Q_PROPERTY(QDaqObjectList outputChannels READ outputChannels WRITE setOutputChannels)
+
+    // the plugin
+    QDaqJobPlugin* plugin_;
+
+    typedef QPointer<QDaqChannel> channel_t;
+    typedef QVector<channel_t> channel_vector_t;
+
+    channel_vector_t inputChannels_, outputChannels_;
+    QVector<QDaqJobInput> in_;
+    QVector<QDaqJobOutput> out_;
+    // updateCount() of input channels when last used
+    QVector<uint> inputUpdates_;
+    // channel lists waiting for applyChannels()
+    channel_vector_t pendingIn_, pendingOut_;
+    bool pending_;
+
+public:
+    Q_INVOKABLE explicit QDaqNativeJob(const QString& name);
+
+    // getters
+    QDaqObjectList inputChannels() const;
+    QDaqObjectList outputChannels() const;
+
+    // setters
+    void setInputChannels(QDaqObjectList lst);
+    void setOutputChannels(QDaqObjectList lst);
+
+public slots:
+    /**
+     * @brief Return a list of available job plugins.
+     * For each plugin the file name is returned, which
+     * can be passed to loadPlugin().
+     * @return A string list of file names.
+     */
+    QStringList listPlugins();
+    /**
+     * @brief Loads the job plugin specified by fname.
+     * @param fname File name of required plugin.
+     * @return True if the plugin is sucessfully loaded.
+     */
+    bool loadPlugin(const QString& fname);
+    /**
+     * @brief Set the input and output channels together.
+     *
+     * If the job is armed the plugin must accept the new numbers of channels
+     * (see QDaqJobPlugin::accepts()). The change is applied between loop cycles
+     * and the plugin is initialized again if the numbers change.
+     */
+    void setChannels(QDaqObjectList in, QDaqObjectList out);
+
+private slots:
+    void applyChannels();
+
+protected:
+    bool toChannels(const QDaqObjectList& lst, channel_vector_t& v);
+    // bind armed plugin to new channel lists, returns false if the plugin rejects them
+    bool rebind(const channel_vector_t& in, const channel_vector_t& out);
+    void setupBuffers(int nin, int nout);
+
+    virtual bool arm_();
+    virtual bool run();
+    // reads the input channels, writes the output channels
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
+};
+
+#endif // QDAQNATIVEJOB_H
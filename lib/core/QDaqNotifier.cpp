@@ -0,0 +1,61 @@
+#include "QDaqNotifier.h"
+#include "QDaqObject.h"
+
+#include <QTimer>
+
+QDaqNotifier::QDaqNotifier(QObject* parent) : QObject(parent), rate_(30.)
+{
+    timer_ = new QTimer(this);
+    connect(timer_,SIGNAL(timeout()),this,SLOT(flush()));
+    timer_->start(qRound(1000./rate_));
+}
+
+void QDaqNotifier::setRate(double r)
+{
+    if (r < 1.) r = 1.;
+    if (r > 1000.) r = 1000.;
+    rate_ = r;
+    timer_->setInterval(qRound(1000./rate_));
+}
+
+void QDaqNotifier::watch(QDaqObject* obj)
+{
+    objects_.insert(obj,QPointer<QDaqObject>(obj));
+}
+
+void QDaqNotifier::unwatch(QDaqObject* obj)
+{
+    objects_.remove(obj);
+}
+
+void QDaqNotifier::flush()
+{
+    // take the flags first, the slots may attach or detach objects
+    QList< QPointer<QDaqObject> > pending;
+    QList<int> flags;
+    object_map_t::iterator i = objects_.begin();
+    while (i != objects_.end())
+    {
+        QDaqObject* obj = i.value();
+        if (!obj)
+        {
+            i = objects_.erase(i);
+            continue;
+        }
+        int f = obj->notifyFlags_.fetchAndStoreAcquire(0);
+        if (f)
+        {
+            pending << i.value();
+            flags << f;
+        }
+        ++i;
+    }
+
+    for(int k=0; k<pending.size(); ++k)
+    {
+        QDaqObject* obj = pending[k];
+        if (!obj) continue;
+        if (flags[k] & QDaqObject::PropertiesChanged) emit obj->propertiesChanged();
+        if (flags[k] & QDaqObject::WidgetsUpdate) emit obj->updateWidgets();
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef QDAQNOTIFIER_H
+#define QDAQNOTIFIER_H
+
+#include "QDaqGlobal.h"
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+
+class QDaqObject;
+class QTimer;
+
+/**
+ * @brief Delivers the GUI notifications of QDaq objects at a fixed frame rate.
+ *
+ * @ingroup Core
+ *
+ * Jobs running in loop threads do not emit QDaqObject::propertiesChanged()
+ * and QDaqObject::updateWidgets() themselves, which would post an event to the GUI
+ * thread at each cycle. They call QDaqObject::notifyGui(), which only sets
+ * atomic flags in the object.
+ *
+ * The notifier lives in the GUI thread. At each frame it checks the flags of
+ * all attached objects, clears them, and emits the requested signals once per object.
+ * Thus widgets are updated at most at the frame rate, however fast the loops run.
+ *
+ * The single notifier is owned by QDaqRoot, see QDaqRoot::refreshRate.
+ *
+ */
+class QDAQ_EXPORT QDaqNotifier : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QDaqNotifier(QObject* parent = 0);
+
+    /// Frames per second.
+    double rate() const { return rate_; }
+    /// Set the frames per second, 1 - 1000.
+    void setRate(double r);
+
+    /// Deliver the notifications of obj (called when obj is attached).
+    void watch(QDaqObject* obj);
+    /// Stop delivering the notifications of obj (called when obj is detached).
+    void unwatch(QDaqObject* obj);
+
+public slots:
+    /// Emit the pending signals of all objects now.
+    void flush();
+
+private:
+    QTimer* timer_;
+    double rate_;
+    // objects deleted without detaching become null
+    typedef QHash<QDaqObject*, QPointer<QDaqObject> > object_map_t;
+    object_map_t objects_;
+};
+
+#endif // QDAQNOTIFIER_H
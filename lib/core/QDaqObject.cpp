@@ -42,12 +42,14 @@ void QDaqObject::attach()
 {
     qDebug() << "attaching" << path() << "@" << (void*)this;
     root()->objectAttached(this);
+    root()->notifier()->watch(this);
     foreach(QDaqObject* obj, children_) obj->attach();    
 }
 
 void QDaqObject::detach()
 {    
     foreach(QDaqObject* obj, children_) obj->detach();
+    root()->notifier()->unwatch(this);
     root()->objectDetached(this);
     qDebug() << "detaching" << path() << "@" << (void*)this;
 }
@@ -7,6 +7,7 @@
 #include <QList>
 #include <QSet>
 #include <QMetaType>
+#include <QAtomicInt>
 #include <QScriptable>
 
 #include "QDaqGlobal.h"
@@ -167,6 +168,27 @@ public:
     /// A critical section for synching thread access to this object
     os::critical_section comm_lock;
 
+    /// Signals requested by notifyGui()
+    enum NotifyFlag {
+        PropertiesChanged = 1, ///< propertiesChanged()
+        WidgetsUpdate = 2      ///< updateWidgets()
+    };
+
+protected:
+    /** Request the signals propertiesChanged() and/or updateWidgets().
+     *
+     * It only sets atomic flags, so it may be called from any thread
+     * at any rate. The signals are emitted in the GUI thread at the next
+     * frame of the QDaqNotifier, once for all requests since the previous frame.
+     *
+     * Jobs running in loop threads use it instead of emitting the signals.
+     */
+    void notifyGui(int flags) { notifyFlags_.fetchAndOrRelaxed(flags); }
+
+private:
+    friend class QDaqNotifier;
+    QAtomicInt notifyFlags_;
+
 protected:
     // the root object
     static QDaqRoot* root_;
@@ -9,6 +9,9 @@
 #include "QDaqDevice.h"
 #include "QDaqGpib.h"
 #include "QDaqFilter.h"
+#include "QDaqDataPlayer.h"
+#include "QDaqNativeJob.h"
+#include "QDaqNotifier.h"
 
 #include <QCoreApplication>
 #include <QDir>
@@ -19,14 +22,20 @@ QDaqRoot::QDaqRoot(void) : QDaqObject("qdaq"), ideWindow_(0)
 {
     root_ = this;
 
+    // objects attach to it
+    notifier_ = new QDaqNotifier(this);
+
     qRegisterMetaType<QDaqError>();
 
     registerClass(&QDaqObject::staticMetaObject);
     registerClass(&QDaqJob::staticMetaObject);
     registerClass(&QDaqLoop::staticMetaObject);
     registerClass(&QDaqChannel::staticMetaObject);
+    registerClass(&QDaqFilterChannel::staticMetaObject);
     registerClass(&QDaqDataBuffer::staticMetaObject);
     registerClass(&QDaqFilter::staticMetaObject);
+    registerClass(&QDaqDataPlayer::staticMetaObject);
+    registerClass(&QDaqNativeJob::staticMetaObject);
 
     // DAQ objects/devices
     registerClass(&QDaqTcpip::staticMetaObject);
@@ -69,6 +78,17 @@ QDaqRoot::~QDaqRoot(void)
     }*/
 }
 
+double QDaqRoot::refreshRate() const
+{
+    return notifier_->rate();
+}
+
+void QDaqRoot::setRefreshRate(double r)
+{
+    notifier_->setRate(r);
+    emit propertiesChanged();
+}
+
 QDaqIDE* QDaqRoot::createIdeWindow()
 {
     if (!ideWindow_) {
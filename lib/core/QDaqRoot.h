@@ -11,6 +11,7 @@
 class QDaqLogFile;
 class QDaqIDE;
 class QDaqSession;
+class QDaqNotifier;
 
 /** QDaq root object class.
  *
@@ -52,6 +53,12 @@ class QDAQ_EXPORT QDaqRoot : public QDaqObject
     Q_PROPERTY(QString rootDir READ rootDir)
     /// The directory where log files are written.
     Q_PROPERTY(QString logDir READ logDir)
+    /** Frame rate of GUI updates in Hz.
+     *
+     * The signals propertiesChanged() and updateWidgets() of objects updated by
+     * running loops are emitted at this rate (see QDaqNotifier). Default is 30.
+     */
+    Q_PROPERTY(double refreshRate READ refreshRate WRITE setRefreshRate)
 
 protected:
     QString rootDir_, logDir_;
@@ -59,6 +66,7 @@ protected:
     QDaqIDE* ideWindow_;
     QDaqSession* rootSession_;
     QDaqErrorQueue error_queue_;
+    QDaqNotifier* notifier_;
 
 public:
     QDaqRoot(void);
@@ -66,6 +74,8 @@ public:
 
     QString rootDir() const { return rootDir_; }
     QString logDir() const { return logDir_; }
+    double refreshRate() const;
+    void setRefreshRate(double r);
 
     QString xml();
 
@@ -103,6 +113,9 @@ public:
     /// Returns a pointer to the root script session.
     QDaqSession* rootSession() { return rootSession_; }
 
+    /// Returns a pointer to the GUI notifier.
+    QDaqNotifier* notifier() { return notifier_; }
+
     /// Returns a pointer to the QDaq error queue.
     const QDaqErrorQueue* errorQueue() const { return &error_queue_; }
 
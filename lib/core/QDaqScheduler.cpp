@@ -0,0 +1,263 @@
+#include "QDaqScheduler.h"
+#include "QDaqJob.h"
+
+QDaqScheduler* QDaqScheduler::instance()
+{
+    static QDaqScheduler s;
+    return &s;
+}
+
+QDaqScheduler::QDaqScheduler() : now_(0), t0_(0), quit_(false)
+{
+    for(int l=0; l<NLevels; ++l)
+        for(int i=0; i<NSlots; ++i) wheel_[l][i] = 0;
+}
+QDaqScheduler::~QDaqScheduler()
+{
+    timer_.stop();
+    stopThreads();
+    qDeleteAll(entries_);
+}
+
+bool QDaqScheduler::startThreads()
+{
+    for(int i=workers_.size(); i<DefaultThreads; ++i)
+    {
+        Worker* w = new Worker;
+        w->s = this;
+        if (w->thread_.start(w)) workers_ << w;
+        else
+        {
+            delete w;
+            break;
+        }
+    }
+    return !workers_.isEmpty();
+}
+void QDaqScheduler::stopThreads()
+{
+    {
+        QMutexLocker L(&mtx_);
+        quit_ = true;
+        workCond_.wakeAll();
+    }
+    foreach(Worker* w, workers_)
+    {
+        w->thread_.wait();
+        delete w;
+    }
+    workers_.clear();
+}
+
+bool QDaqScheduler::add(QDaqLoop* loop, unsigned int period_us)
+{
+    QMutexLocker C(&ctrlMtx_);
+    QMutexLocker L(&mtx_);
+    if (entries_.contains(loop)) return true;
+
+    if (!startThreads()) return false;
+    if (!timer_.is_running())
+    {
+        // the wheel is empty, restart the clock
+        now_ = 0;
+        t0_ = os::clock_ns();
+        if (!timer_.start(this,TickUs)) return false;
+    }
+
+    Entry* e = new Entry;
+    e->loop = loop;
+    e->period = (period_us + TickUs/2)/TickUs;
+    if (e->period < 1) e->period = 1;
+    e->due = now_ + e->period;
+    e->dueNs = 0;
+    e->missed = 0;
+    e->running = e->queued = e->removed = false;
+    e->slot = 0;
+    e->prev = e->next = 0;
+    entries_.insert(loop,e);
+    insert(e);
+    return true;
+}
+
+void QDaqScheduler::remove(QDaqLoop* loop)
+{
+    QMutexLocker C(&ctrlMtx_);
+    bool idle;
+    {
+        QMutexLocker L(&mtx_);
+        // an aborted loop has already been removed
+        Entry* e = entries_.value(loop);
+        if (e)
+        {
+            // stop scheduling it, then wait for a running cycle to end
+            unlink(e);
+            if (e->queued) ready_.removeOne(e);
+            e->queued = false;
+            e->removed = true;
+            while (e->running) doneCond_.wait(&mtx_);
+            entries_.remove(loop);
+            delete e;
+        }
+        idle = entries_.isEmpty();
+    }
+    // no ticks needed without loops
+    if (idle) timer_.stop();
+}
+
+void QDaqScheduler::setPeriod(QDaqLoop* loop, unsigned int period_us)
+{
+    QMutexLocker L(&mtx_);
+    Entry* e = entries_.value(loop);
+    if (!e || e->removed) return;
+
+    qint64 p = (period_us + TickUs/2)/TickUs;
+    if (p < 1) p = 1;
+    // move the next due time
+    unlink(e);
+    e->due += p - e->period;
+    if (e->due <= now_) e->due = now_ + 1;
+    e->period = p;
+    insert(e);
+}
+
+int QDaqScheduler::loopCount()
+{
+    QMutexLocker L(&mtx_);
+    return entries_.size();
+}
+
+void QDaqScheduler::insert(Entry* e)
+{
+    // find the finest level that covers the time to go
+    qint64 delta = e->due - now_;
+    int level = 0;
+    while (level < NLevels-1 && delta >= ((qint64)1 << (SlotBits*(level+1)))) level++;
+    // beyond the wheel range: park in the last slot, it will be put back when cascaded
+    qint64 d = e->due;
+    qint64 range = (qint64)1 << (SlotBits*NLevels);
+    if (delta >= range) d = now_ + range - 1;
+
+    Entry** head = &wheel_[level][(d >> (SlotBits*level)) & (NSlots-1)];
+    e->slot = head;
+    e->prev = 0;
+    e->next = *head;
+    if (*head) (*head)->prev = e;
+    *head = e;
+}
+
+void QDaqScheduler::unlink(Entry* e)
+{
+    if (!e->slot) return;
+    if (e->prev) e->prev->next = e->next;
+    else *e->slot = e->next;
+    if (e->next) e->next->prev = e->prev;
+    e->slot = 0;
+    e->prev = e->next = 0;
+}
+
+void QDaqScheduler::cascade(int level)
+{
+    if (level >= NLevels) return;
+    int idx = (now_ >> (SlotBits*level)) & (NSlots-1);
+
+    // move the entries of the current slot to finer levels
+    Entry* e = wheel_[level][idx];
+    wheel_[level][idx] = 0;
+    while (e)
+    {
+        Entry* nx = e->next;
+        insert(e);
+        e = nx;
+    }
+
+    // the next coarser level comes up as well
+    if (!idx) cascade(level+1);
+}
+
+void QDaqScheduler::expire(Entry* e)
+{
+    qint64 due = e->due;
+    // next due time from the previous one, no drift
+    e->due += e->period;
+    insert(e);
+
+    if (e->running || e->queued) e->missed++;
+    else
+    {
+        e->dueNs = t0_ + due*TickUs*1000;
+        e->queued = true;
+        ready_ << e;
+    }
+}
+
+bool QDaqScheduler::operator()()
+{
+    QMutexLocker L(&mtx_);
+
+    // advance by the elapsed ticks, including those missed by the tick thread
+    uint n = 1 + timer_.last_missed();
+    for(uint k=0; k<n; ++k)
+    {
+        now_++;
+        int idx = now_ & (NSlots-1);
+        if (!idx) cascade(1);
+
+        Entry* e = wheel_[0][idx];
+        wheel_[0][idx] = 0;
+        while (e)
+        {
+            Entry* nx = e->next;
+            e->slot = 0;
+            expire(e);
+            e = nx;
+        }
+    }
+
+    if (!ready_.isEmpty()) workCond_.wakeAll();
+    return true;
+}
+
+void QDaqScheduler::workerLoop()
+{
+    QMutexLocker L(&mtx_);
+    forever
+    {
+        while (!quit_ && ready_.isEmpty()) workCond_.wait(&mtx_);
+        if (quit_) return;
+
+        Entry* e = ready_.takeFirst();
+        e->queued = false;
+        e->running = true;
+        uint missed = e->missed;
+        e->missed = 0;
+        qint64 latency = os::clock_ns() - e->dueNs;
+        QDaqLoop* loop = e->loop;
+
+        L.unlock();
+        bool ok = loop->timerCycle(latency,missed);
+        L.relock();
+
+        e->running = false;
+        if (e->removed)
+        {
+            // remove() is waiting to delete it
+        }
+        else if (!ok)
+        {
+            // the loop aborted
+            unlink(e);
+            entries_.remove(loop);
+            delete e;
+        }
+        else if (e->missed)
+        {
+            // became due while running: start at once, like a timer that has
+            // expired, the rest is reported as missed
+            e->missed--;
+            e->dueNs = os::clock_ns();
+            e->queued = true;
+            ready_ << e;
+        }
+        doneCond_.wakeAll();
+    }
+}
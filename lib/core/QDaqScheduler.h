@@ -0,0 +1,113 @@
+#ifndef QDAQSCHEDULER_H
+#define QDAQSCHEDULER_H
+
+#include "os_utils.h"
+
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QDaqLoop;
+
+/**
+ * @brief A timer shared by many top level loops.
+ *
+ * @ingroup Core
+ *
+ * Loops with QDaqLoop::sharedTimer set do not start their own timer thread.
+ * They are registered with the single QDaqScheduler instance, which keeps their
+ * next due times in a hierarchical timer wheel driven by one 1 ms timer thread.
+ * When a loop is due it is passed to a small pool of worker threads
+ * that run its cycle. The number of threads stays the same whatever the
+ * number of loops.
+ *
+ * The wheel has 4 levels of 64 slots with a resolution of 1 ms, covering
+ * 64 ms, 4 s, 4.4 min and 4.7 h. Insertion, removal and expiration
+ * take constant time; entries are moved to a finer level when their
+ * coarse slot comes up.
+ *
+ * Due times are computed from the previous due time, so the periods do not drift.
+ * If a loop is still running when it becomes due again, the cycle is
+ * counted as missed and handled by the loop's overrun policy.
+ *
+ */
+class QDaqScheduler
+{
+public:
+    enum {
+        TickUs = 1000,   // wheel resolution
+        SlotBits = 6,
+        NSlots = 1 << SlotBits,
+        NLevels = 4,
+        DefaultThreads = 2
+    };
+
+    /// The scheduler instance, created on first use.
+    static QDaqScheduler* instance();
+
+    /// Start calling loop->timerCycle() every period_us. Returns false if the threads cannot start.
+    bool add(QDaqLoop* loop, unsigned int period_us);
+    /// Stop scheduling the loop. Waits if a cycle of the loop is running on another thread.
+    void remove(QDaqLoop* loop);
+    /// Change the period of a scheduled loop, counting from its last due time.
+    void setPeriod(QDaqLoop* loop, unsigned int period_us);
+
+    /// Number of scheduled loops.
+    int loopCount();
+    /// Number of worker threads.
+    int threadCount() const { return workers_.size(); }
+
+private:
+    QDaqScheduler();
+    ~QDaqScheduler();
+
+    struct Entry
+    {
+        QDaqLoop* loop;
+        qint64 period; // ticks
+        qint64 due;    // tick
+        qint64 dueNs;  // nominal time of the current cycle (os::clock_ns)
+        uint missed;   // due times passed while running or queued
+        bool running, queued, removed;
+        Entry **slot, *prev, *next; // in a wheel slot
+    };
+
+    // doubly linked list heads, one per slot
+    Entry* wheel_[NLevels][NSlots];
+    qint64 now_;    // last processed tick
+    qint64 t0_;     // time of tick 0 (ns)
+    QHash<QDaqLoop*, Entry*> entries_;
+    QList<Entry*> ready_;
+
+    QMutex mtx_;
+    QWaitCondition workCond_, doneCond_;
+    // serializes add()/remove(), which start and stop the tick thread
+    QMutex ctrlMtx_;
+    bool quit_;
+
+    void insert(Entry* e);
+    void unlink(Entry* e);
+    void cascade(int level);
+    void expire(Entry* e);
+
+    // the 1 ms tick thread
+    friend class os::timer<QDaqScheduler>;
+    os::timer<QDaqScheduler> timer_;
+    bool operator()();
+
+    // worker threads
+    struct Worker
+    {
+        QDaqScheduler* s;
+        os::thread<Worker> thread_;
+        void operator()() { s->workerLoop(); }
+    };
+    friend struct Worker;
+    QList<Worker*> workers_;
+    void workerLoop();
+    bool startThreads();
+    void stopThreads();
+};
+
+#endif // QDAQSCHEDULER_H
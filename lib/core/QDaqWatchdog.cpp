@@ -0,0 +1,100 @@
+#include "QDaqWatchdog.h"
+#include "QDaqJob.h"
+
+QDaqWatchdog* QDaqWatchdog::instance()
+{
+    static QDaqWatchdog w;
+    return &w;
+}
+
+QDaqWatchdog::QDaqWatchdog() : pollMs_(MaxPollMs), quit_(false)
+{
+    runner_.w = this;
+}
+QDaqWatchdog::~QDaqWatchdog()
+{
+    stop();
+}
+
+bool QDaqWatchdog::add(QDaqJob* job)
+{
+    QMutexLocker C(&ctrlMtx_);
+    {
+        QMutexLocker L(&mtx_);
+        if (!jobs_.contains(job)) jobs_.insert(job,0);
+        computePoll();
+        cond_.wakeAll();
+    }
+    if (thread_.is_running()) return true;
+    quit_ = false;
+    return thread_.start(&runner_);
+}
+
+void QDaqWatchdog::remove(QDaqJob* job)
+{
+    QMutexLocker C(&ctrlMtx_);
+    bool idle;
+    {
+        // a scan in progress holds the mutex
+        QMutexLocker L(&mtx_);
+        jobs_.remove(job);
+        computePoll();
+        idle = jobs_.isEmpty();
+    }
+    // no thread needed without jobs
+    if (idle) stop();
+}
+
+int QDaqWatchdog::jobCount()
+{
+    QMutexLocker L(&mtx_);
+    return jobs_.size();
+}
+
+void QDaqWatchdog::stop()
+{
+    if (!thread_.is_running()) return;
+    {
+        QMutexLocker L(&mtx_);
+        quit_ = true;
+        cond_.wakeAll();
+    }
+    thread_.wait();
+}
+
+void QDaqWatchdog::computePoll()
+{
+    // half the smallest budget, so that a stall is seen within 1.5 budgets
+    qint64 b = 0;
+    foreach(QDaqJob* j, jobs_.keys())
+        if (j->budget_ && (!b || j->budget_ < b)) b = j->budget_;
+    qint64 ms = b/2000000;
+    if (!b || ms > MaxPollMs) ms = MaxPollMs;
+    if (ms < MinPollMs) ms = MinPollMs;
+    pollMs_ = (unsigned long)ms;
+}
+
+void QDaqWatchdog::check()
+{
+    qint64 now = os::clock_ns();
+    QHash<QDaqJob*, qint64>::iterator i = jobs_.begin();
+    for(; i!=jobs_.end(); ++i)
+    {
+        QDaqJob* j = i.key();
+        qint64 start = j->runStart_, budget = j->budget_;
+        // report each run once
+        if (!start || !budget || start==i.value() || now - start <= budget) continue;
+        i.value() = start;
+        j->budgetStall(now - start);
+    }
+}
+
+void QDaqWatchdog::run()
+{
+    QMutexLocker L(&mtx_);
+    while (!quit_)
+    {
+        check();
+        cond_.wait(&mtx_,pollMs_);
+    }
+}
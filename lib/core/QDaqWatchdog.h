@@ -0,0 +1,78 @@
+#ifndef QDAQWATCHDOG_H
+#define QDAQWATCHDOG_H
+
+#include "os_utils.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QDaqJob;
+
+/**
+ * @brief Detects jobs that exceed their time budget while they are still running.
+ *
+ * @ingroup Core
+ *
+ * Armed jobs with a QDaqJob::budget are registered with the single QDaqWatchdog
+ * instance. Its thread polls them at half the smallest budget (1 to 100 ms)
+ * and reports an error as soon as a job, or a loop cycle, runs longer than its budget,
+ * e.g. when a device read blocks until its timeout. For a loop the report
+ * names the job that is running at that moment.
+ *
+ * The watchdog only reports; the job cannot be interrupted. The overrun is
+ * measured and contained by the loop when the job returns (see QDaqLoop::budgetAction).
+ *
+ * remove() waits for a scan in progress, so a disarmed job is not accessed
+ * by the watchdog thread any more. QDaqJob::disarm_() calls it for every job.
+ *
+ */
+class QDaqWatchdog
+{
+public:
+    enum {
+        MinPollMs = 1,
+        MaxPollMs = 100
+    };
+
+    /// The watchdog instance, created on first use.
+    static QDaqWatchdog* instance();
+
+    /// Start watching the job, or update its budget. Returns false if the thread cannot start.
+    bool add(QDaqJob* job);
+    /// Stop watching the job. Waits if the job is being checked.
+    void remove(QDaqJob* job);
+
+    /// Number of watched jobs.
+    int jobCount();
+
+private:
+    QDaqWatchdog();
+    ~QDaqWatchdog();
+
+    // watched jobs and the start time of their last reported run
+    QHash<QDaqJob*, qint64> jobs_;
+    unsigned long pollMs_;
+
+    QMutex mtx_;
+    QWaitCondition cond_;
+    // serializes add()/remove(), which start and stop the thread
+    QMutex ctrlMtx_;
+    bool quit_;
+
+    void computePoll();
+    void check();
+
+    struct Runner
+    {
+        QDaqWatchdog* w;
+        void operator()() { w->run(); }
+    };
+    friend struct Runner;
+    Runner runner_;
+    os::thread<Runner> thread_;
+    void run();
+    void stop();
+};
+
+#endif // QDAQWATCHDOG_H
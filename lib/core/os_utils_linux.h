@@ -3,7 +3,10 @@
 
 #include <time.h>
 #include <pthread.h>
+#include <sched.h>
 #include <sys/timerfd.h>
+#include <sys/mman.h>
+#include <errno.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -123,6 +126,14 @@ public:
 
 #define SW_CLOCK_ID CLOCK_MONOTONIC
 
+/// Time of a monotonic clock in ns, for timing short code sections
+inline long long clock_ns()
+{
+    timespec t;
+    clock_gettime(SW_CLOCK_ID,&t);
+    return t.tv_sec*1000000000LL + t.tv_nsec;
+}
+
 class stopwatch
 {
     bool running_;
@@ -279,9 +290,48 @@ public:
 
 
 
+// bytes of stack touched by a timer thread with locked memory
+#define TIMER_STACK_PREFAULT (256*1024)
+
+// Process memory lock shared by the timers with lock_memory.
+// mlockall() applies to the whole process, so the memory is
+// unlocked only when the last timer that locked it stops.
+class memory_lock
+{
+    static mutex& mtx() { static mutex m; return m; }
+    static int& count() { static int n = 0; return n; }
+public:
+    // returns 0 or the errno of mlockall()
+    static int acquire()
+    {
+        mutex_lock L(mtx());
+        if (count()==0 && mlockall(MCL_CURRENT | MCL_FUTURE)) return errno;
+        count()++;
+        return 0;
+    }
+    static void release()
+    {
+        mutex_lock L(mtx());
+        if (count()>0 && --count()==0) munlockall();
+    }
+};
+
 /** timer thread
   * A timer thread implemented using timer_create() + signal
   * + a thread that watches for the signal
+  *
+  * The period is given in microseconds.
+  *
+  * Real-time options, set before start():
+  *   - priority: if > 0 the thread runs with SCHED_FIFO at this priority (1-99)
+  *   - cpu: if >= 0 the thread runs only on this cpu
+  *   - lock_memory: lock the process memory with mlockall() and pre-fault
+  *     the thread stack, so that no page faults occur in the loop.
+  *     The memory is unlocked when the last timer with lock_memory stops.
+  *
+  * The options are applied by the timer thread before start() returns.
+  * If some of them fails (e.g. no permission for SCHED_FIFO) the timer
+  * runs anyway and error() describes the problem.
   */
 template<class Functor>
 class timer
@@ -300,30 +350,88 @@ class timer
     thread<myFunctor> thread_;
 
     int timer_fd;
-    unsigned long long wakeups_missed;
-    unsigned int period; // ms
+    unsigned long long wakeups_missed; // since arming
+    unsigned int last_missed_;         // at the last wake-up
+    unsigned int period; // us
+    volatile unsigned int new_period_; // set by set_period() while running, 0 if none
+    timespec t0_;                // time of arming
+    unsigned long long ticks_;   // timer expirations since arming
+    long long latency_;          // ns, delay of the last wake-up
     myFunctor myF;
     Functor* F;
 
     volatile int continue_;
 
+    // real-time options
+    int priority_, cpu_;
+    bool lock_memory_;
+    // memory_lock acquired by setup()
+    bool locked_;
+    char error_[128];
+
+    // handshake with start()
+    mutex setup_mtx;
+    wait_condition setup_cond;
+    volatile int setup_done;
+
     // Arm/disarm the timer
-    int arm (unsigned ms)
+    int arm (unsigned us)
     {
         unsigned int ns;
         unsigned int sec;
         itimerspec itval;
 
-        if (ms) {
-            sec = period/1000;
-            ns = (period - (sec * 1000)) * 1000000;
+        if (us) {
+            sec = us/1000000;
+            ns = (us - (sec * 1000000)) * 1000;
         }
         else sec=ns=0;
         itval.it_interval.tv_sec = sec;
         itval.it_interval.tv_nsec = ns;
-        itval.it_value.tv_sec = sec;
-        itval.it_value.tv_nsec = ns;
-        return timerfd_settime (timer_fd, 0, &itval, NULL);
+        if (!us)
+        {
+            itval.it_value.tv_sec = itval.it_value.tv_nsec = 0;
+            return timerfd_settime (timer_fd, 0, &itval, NULL);
+        }
+
+        // absolute first expiration, so that the
+        // k-th expiration is exactly at t0_ + k*period
+        clock_gettime(CLOCK_MONOTONIC,&t0_);
+        ticks_ = 0;
+        wakeups_missed = 0;
+        last_missed_ = 0;
+        latency_ = 0;
+        itval.it_value.tv_sec = t0_.tv_sec + sec;
+        itval.it_value.tv_nsec = t0_.tv_nsec + ns;
+        if (itval.it_value.tv_nsec >= 1000000000)
+        {
+            itval.it_value.tv_nsec -= 1000000000;
+            itval.it_value.tv_sec++;
+        }
+        return timerfd_settime (timer_fd, TFD_TIMER_ABSTIME, &itval, NULL);
+    }
+
+    // Change the period, counting from the last expiration.
+    // The missed wake-ups are kept.
+    int rearm (unsigned us)
+    {
+        long long ns = t0_.tv_nsec + (long long)ticks_*period*1000;
+        t0_.tv_sec += ns / 1000000000;
+        t0_.tv_nsec = ns % 1000000000;
+        ticks_ = 0;
+        period = us;
+
+        itimerspec itval;
+        itval.it_interval.tv_sec = us/1000000;
+        itval.it_interval.tv_nsec = (us % 1000000) * 1000;
+        itval.it_value.tv_sec = t0_.tv_sec + itval.it_interval.tv_sec;
+        itval.it_value.tv_nsec = t0_.tv_nsec + itval.it_interval.tv_nsec;
+        if (itval.it_value.tv_nsec >= 1000000000)
+        {
+            itval.it_value.tv_nsec -= 1000000000;
+            itval.it_value.tv_sec++;
+        }
+        return timerfd_settime (timer_fd, TFD_TIMER_ABSTIME, &itval, NULL);
     }
 
     int wait_period ()
@@ -331,8 +439,8 @@ class timer
         unsigned long long missed;
         int ret;
 
-        /* Wait for the next timer event. If we have missed any the
-           number is written to "missed" */
+        /* Wait for the next timer event. The number of expirations
+           since the last read is written to "missed" */
         ret = read (timer_fd, &missed, sizeof (missed));
         if (ret == -1)
         {
@@ -340,41 +448,135 @@ class timer
             return ret;
         }
 
-        wakeups_missed += missed;
+        last_missed_ = missed > 1 ? (unsigned int)(missed - 1) : 0;
+        wakeups_missed += last_missed_;
+
+        // wake-up latency relative to the last expiration
+        timespec t;
+        clock_gettime(CLOCK_MONOTONIC,&t);
+        ticks_ += missed;
+        latency_ = (t.tv_sec - t0_.tv_sec)*1000000000LL + (t.tv_nsec - t0_.tv_nsec)
+                - (long long)ticks_*period*1000;
 
         return ret;
     }
 
+    void set_error(const char* what, int err)
+    {
+        if (!error_[0]) snprintf(error_,sizeof(error_),"%s: %s",what,strerror(err));
+    }
+
+    static void prefault_stack()
+    {
+        volatile unsigned char buff[TIMER_STACK_PREFAULT];
+        for(int i=0; i<TIMER_STACK_PREFAULT; i+=4096) buff[i] = 0;
+        (void)buff;
+    }
+
+    void setup()
+    {
+        error_[0] = 0;
+        locked_ = false;
+        if (lock_memory_)
+        {
+            int err = memory_lock::acquire();
+            if (err) set_error("mlockall",err);
+            else locked_ = true;
+            prefault_stack();
+        }
+        if (cpu_>=0)
+        {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(cpu_,&cpus);
+            int ret = pthread_setaffinity_np(pthread_self(),sizeof(cpus),&cpus);
+            if (ret) set_error("pthread_setaffinity_np",ret);
+        }
+        if (priority_>0)
+        {
+            sched_param p;
+            p.sched_priority = priority_;
+            int ret = pthread_setschedparam(pthread_self(),SCHED_FIFO,&p);
+            if (ret) set_error("pthread_setschedparam",ret);
+        }
+
+        setup_mtx.lock();
+        setup_done = 1;
+        setup_cond.signal();
+        setup_mtx.unlock();
+    }
+
     void timer_func()
     {
+        setup();
         arm(period);
         wait_period();
-        while (continue_ && F->operator()()) wait_period();
+        while (continue_ && F->operator()())
+        {
+            unsigned int p = new_period_;
+            if (p)
+            {
+                new_period_ = 0;
+                rearm(p);
+            }
+            wait_period();
+        }
         arm(0);
+        if (locked_) memory_lock::release();
+        locked_ = false;
     }
 
 public:
-    timer()
+    timer() : wakeups_missed(0), last_missed_(0), new_period_(0), ticks_(0), latency_(0), priority_(0), cpu_(-1), lock_memory_(false), locked_(false)
     {
         timer_fd = timerfd_create(CLOCK_MONOTONIC,0);
+        error_[0] = 0;
     }
     ~timer()
     {
         stop();
         if (timer_fd!=-1) close(timer_fd);
     }
-    bool start(Functor* f, unsigned int ms)
+    bool start(Functor* f, unsigned int us)
     {
         stop();
 
         // copy options
         F = f;
-        period = ms;
+        period = us;
+        new_period_ = 0;
         myF.t = this;
         continue_ = true;
+        setup_done = 0;
 
-        return thread_.start(&myF);
+        if (!thread_.start(&myF)) return false;
+
+        // wait for the real-time setup
+        setup_mtx.lock();
+        while (!setup_done) setup_cond.wait(setup_mtx);
+        setup_mtx.unlock();
+
+        return true;
     }
+    // Change the period (us). If the timer is running, the new period
+    // starts at the next wake-up, without restarting the thread.
+    void set_period(unsigned int us)
+    {
+        if (thread_.is_running()) new_period_ = us;
+        else period = us;
+    }
+    void set_priority(int p) { priority_ = p; }
+    void set_cpu(int cpu) { cpu_ = cpu; }
+    void set_lock_memory(bool on) { lock_memory_ = on; }
+    // description of failed real-time setup, empty if none
+    const char* error() const { return error_; }
+    // delay (ns) of the last wake-up after the timer expiration,
+    // valid when called from the functor
+    long long latency() const { return latency_; }
+    // timer periods that elapsed without a wake-up, before the last
+    // wake-up / in total since start()
+    unsigned int last_missed() const { return last_missed_; }
+    unsigned long long missed() const { return wakeups_missed; }
     bool is_running() const
     {
         return thread_.is_running();
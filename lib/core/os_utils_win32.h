@@ -77,6 +77,17 @@ public:
     }
 };
 
+/// Time of a monotonic clock in ns, for timing short code sections
+inline long long clock_ns()
+{
+    static __int64 f = 0;
+    __int64 t;
+    if (!f) QueryPerformanceFrequency((LARGE_INTEGER*)&f);
+    QueryPerformanceCounter((LARGE_INTEGER*)&t);
+    // split to avoid overflow of t*1e9
+    return (t/f)*1000000000LL + ((t%f)*1000000000LL)/f;
+}
+
 /**
  * @brief A high resolution stop-watch
  *
@@ -258,6 +269,14 @@ public:
 
 /** timer thread
   * A timer thread implemented using timeSetEvent() function
+  *
+  * The period is given in microseconds but the resolution
+  * of the multimedia timer is 1 ms.
+  *
+  * Real-time options, set before start():
+  *   - priority: if > 0 the thread runs with THREAD_PRIORITY_TIME_CRITICAL
+  *   - cpu: if >= 0 the thread runs only on this cpu
+  *   - lock_memory: not supported, error() reports it
   */
 template<class Functor>
 class timer
@@ -276,8 +295,13 @@ class timer
     thread<myFunctor> thread_;
 
     int timerId;
-    unsigned long long wakeups_missed;
+    unsigned long long wakeups_missed; // since arming
+    unsigned int last_missed_;         // at the last wake-up
     unsigned int period; // ms
+    volatile unsigned int new_period_; // us, set by set_period() while running, 0 if none
+    __int64 t0_, freq_;          // performance counter at arming and its frequency
+    unsigned long long nticks_;  // timer callbacks since arming
+    long long latency_;          // ns, delay of the last wake-up
     myFunctor myF;
     Functor* F;
     critical_section cs;
@@ -287,6 +311,31 @@ class timer
 
     volatile int continue_;
 
+    // real-time options
+    int priority_, cpu_;
+    bool lock_memory_;
+    const char* error_;
+
+    // handshake with start()
+    critical_section setup_cs;
+    wait_condition setup_cond;
+    volatile int setup_done;
+
+    void setup()
+    {
+        error_ = "";
+        if (cpu_>=0 && !SetThreadAffinityMask(GetCurrentThread(),((DWORD_PTR)1) << cpu_))
+            error_ = "SetThreadAffinityMask failed";
+        if (priority_>0 && !SetThreadPriority(GetCurrentThread(),THREAD_PRIORITY_TIME_CRITICAL))
+            error_ = "SetThreadPriority failed";
+        if (lock_memory_) error_ = "Memory locking is not supported";
+
+        setup_cs.lock();
+        setup_done = 1;
+        setup_cond.signal();
+        setup_cs.unlock();
+    }
+
     // windows timer callback
     static void CALLBACK _timerProc(UINT wTimerID, UINT msg, DWORD dwUser, DWORD dw1, DWORD dw2)
     {
@@ -303,6 +352,11 @@ class timer
     {
         if (ms)
         {
+            QueryPerformanceCounter((LARGE_INTEGER*)&t0_);
+            ticks = nticks_ = 0;
+            wakeups_missed = 0;
+            last_missed_ = 0;
+            latency_ = 0;
             timerId = timeSetEvent(ms,0,_timerProc,(DWORD)this,
                 TIME_CALLBACK_FUNCTION | TIME_PERIODIC); // TIME_KILL_SYNCHRONOUS only winXP
 
@@ -316,10 +370,25 @@ class timer
         return timerId;
     }
 
+    // Change the period, counting from now.
+    // The missed wake-ups are kept.
+    void rearm (unsigned ms)
+    {
+        if (timerId) timeKillEvent(timerId);
+        cs.lock();
+        QueryPerformanceCounter((LARGE_INTEGER*)&t0_);
+        ticks = nticks_ = 0;
+        period = ms;
+        cs.unlock();
+        timerId = timeSetEvent(ms,0,_timerProc,(DWORD)this,
+            TIME_CALLBACK_FUNCTION | TIME_PERIODIC);
+    }
+
     int timer_signal()
     {
         cs.lock();
         ticks++;
+        nticks_++;
         cond.signal();
         cs.unlock();
         return 0;
@@ -328,24 +397,43 @@ class timer
     int wait_period ()
     {
         cs.lock();
-        if (ticks) wakeups_missed += ticks; // the clock has already ticked
-        cond.wait(cs);
+        // if the clock has already ticked return at once
+        while (!ticks) cond.wait(cs);
+        last_missed_ = ticks - 1;
+        wakeups_missed += last_missed_;
         ticks = 0;
+        unsigned long long n = nticks_;
         cs.unlock();
+
+        // wake-up latency relative to the nominal time of the last tick
+        __int64 t;
+        QueryPerformanceCounter((LARGE_INTEGER*)&t);
+        latency_ = (long long)((t - t0_)*1.e9/freq_) - (long long)(n*period)*1000000LL;
         return 0;
     }
 
     void timer_func()
     {
+        setup();
         arm(period);
         wait_period();
-        while (continue_ && F->operator()()) wait_period();
+        while (continue_ && F->operator()())
+        {
+            unsigned int us = new_period_;
+            if (us)
+            {
+                new_period_ = 0;
+                rearm(us < 1000 ? 1 : (us + 500)/1000);
+            }
+            wait_period();
+        }
         arm(0);
     }
 
 public:
-    timer() : timerId(0)
+    timer() : timerId(0), wakeups_missed(0), last_missed_(0), new_period_(0), nticks_(0), latency_(0), priority_(0), cpu_(-1), lock_memory_(false), error_("")
     {
+        QueryPerformanceFrequency((LARGE_INTEGER*)&freq_);
         timeBeginPeriod(1U);
     }
     virtual ~timer()
@@ -353,18 +441,51 @@ public:
         stop();
         timeEndPeriod(1U);
     }
-    bool start(Functor* f, unsigned int ms)
+    bool start(Functor* f, unsigned int us)
     {
         stop();
 
         // copy options
         F = f;
-        period = ms;
+        period = (us + 500)/1000;
+        if (period==0) period = 1;
+        new_period_ = 0;
         myF.t = this;
         continue_ = true;
+        setup_done = 0;
 
-        return thread_.start(&myF);
+        if (!thread_.start(&myF)) return false;
+
+        // wait for the real-time setup
+        setup_cs.lock();
+        while (!setup_done) setup_cond.wait(setup_cs);
+        setup_cs.unlock();
+
+        return true;
+    }
+    // Change the period (us). If the timer is running, the new period
+    // starts at the next wake-up, without restarting the thread.
+    void set_period(unsigned int us)
+    {
+        if (thread_.is_running()) new_period_ = us;
+        else
+        {
+            period = (us + 500)/1000;
+            if (period==0) period = 1;
+        }
     }
+    void set_priority(int p) { priority_ = p; }
+    void set_cpu(int cpu) { cpu_ = cpu; }
+    void set_lock_memory(bool on) { lock_memory_ = on; }
+    // description of failed real-time setup, empty if none
+    const char* error() const { return error_; }
+    // delay (ns) of the last wake-up after the nominal tick time,
+    // valid when called from the functor
+    long long latency() const { return latency_; }
+    // timer periods that elapsed without a wake-up, before the last
+    // wake-up / in total since start()
+    unsigned int last_missed() const { return last_missed_; }
+    unsigned long long missed() const { return wakeups_missed; }
     bool is_running() const
     {
         return thread_.is_running();
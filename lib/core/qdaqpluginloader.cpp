@@ -0,0 +1,144 @@
+#include "qdaqpluginloader.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QLibraryInfo>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+QDaqPluginIndex* QDaqPluginIndex::instance()
+{
+    static QDaqPluginIndex idx;
+    return &idx;
+}
+
+QDaqPluginIndex::QDaqPluginIndex() : dirty_(false)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!dir.isEmpty()) cacheFile_ = QDir(dir).absoluteFilePath("plugins.json");
+    load();
+}
+QDaqPluginIndex::~QDaqPluginIndex()
+{
+}
+
+QStringList QDaqPluginIndex::dirs() const
+{
+    QStringList S;
+
+    // first look at app path
+    QDir pluginsDir = QDir(QCoreApplication::applicationDirPath());
+#if defined(Q_OS_WIN)
+    if (pluginsDir.dirName().toLower() == "debug" || pluginsDir.dirName().toLower() == "release")
+        pluginsDir.cdUp();
+#elif defined(Q_OS_MAC)
+    if (pluginsDir.dirName() == "MacOS") {
+        pluginsDir.cdUp();
+        pluginsDir.cdUp();
+        pluginsDir.cdUp();
+    }
+#endif
+    if (pluginsDir.cd("plugins")) S << pluginsDir.absolutePath();
+
+    // now look at Qt plugin folder
+    pluginsDir = QDir(QLibraryInfo::location(QLibraryInfo::PluginsPath));
+    if (pluginsDir.cd("qdaq")) S << pluginsDir.absolutePath();
+
+    return S;
+}
+
+QStringList QDaqPluginIndex::find(const QString& iid)
+{
+    QStringList S;
+    QMutexLocker L(&mtx_);
+    foreach (QString d, dirs()) {
+        QDir pluginsDir(d);
+        foreach (QFileInfo fi, pluginsDir.entryInfoList(QDir::Files)) {
+            if (iidOf(fi) == iid) S.push_back(fi.fileName());
+        }
+    }
+    save();
+    return S;
+}
+
+QString QDaqPluginIndex::path(const QString& fileName, const QString& iid)
+{
+    QMutexLocker L(&mtx_);
+    QString ret;
+    foreach (QString d, dirs()) {
+        QFileInfo fi(QDir(d).absoluteFilePath(fileName));
+        if (fi.isFile() && iidOf(fi) == iid) {
+            ret = fi.absoluteFilePath();
+            break;
+        }
+    }
+    save();
+    return ret;
+}
+
+QString QDaqPluginIndex::iidOf(const QFileInfo& fi)
+{
+    QString fname = fi.absoluteFilePath();
+    qint64 mtime = fi.lastModified().toMSecsSinceEpoch();
+    qint64 size = fi.size();
+
+    QHash<QString, Entry>::const_iterator i = entries_.constFind(fname);
+    if (i != entries_.constEnd() && i->mtime == mtime && i->size == size)
+        return i->iid;
+
+    // read the metadata, the library is not loaded
+    Entry e;
+    e.mtime = mtime;
+    e.size = size;
+    e.iid = QPluginLoader(fname).metaData().value("IID").toString();
+    entries_.insert(fname, e);
+    dirty_ = true;
+    return e.iid;
+}
+
+void QDaqPluginIndex::load()
+{
+    if (cacheFile_.isEmpty()) return;
+    QFile f(cacheFile_);
+    if (!f.open(QIODevice::ReadOnly)) return;
+
+    QJsonObject plugins = QJsonDocument::fromJson(f.readAll()).object().value("plugins").toObject();
+    for (QJsonObject::const_iterator i = plugins.constBegin(); i != plugins.constEnd(); ++i) {
+        QJsonObject o = i.value().toObject();
+        Entry e;
+        e.mtime = (qint64)o.value("mtime").toDouble();
+        e.size = (qint64)o.value("size").toDouble();
+        e.iid = o.value("iid").toString();
+        entries_.insert(i.key(), e);
+    }
+}
+
+void QDaqPluginIndex::save()
+{
+    if (!dirty_ || cacheFile_.isEmpty()) return;
+
+    // files that were removed are dropped
+    QJsonObject plugins;
+    for (QHash<QString, Entry>::const_iterator i = entries_.constBegin(); i != entries_.constEnd(); ++i) {
+        if (!QFileInfo(i.key()).exists()) continue;
+        QJsonObject o;
+        o.insert("mtime", (double)i->mtime);
+        o.insert("size", (double)i->size);
+        o.insert("iid", i->iid);
+        plugins.insert(i.key(), o);
+    }
+    QJsonObject root;
+    root.insert("plugins", plugins);
+
+    QDir().mkpath(QFileInfo(cacheFile_).absolutePath());
+    QSaveFile f(cacheFile_);
+    if (!f.open(QIODevice::WriteOnly)) return;
+    f.write(QJsonDocument(root).toJson());
+    // retried at the next save() if it failed
+    if (f.commit()) dirty_ = false;
+}
@@ -1,104 +1,92 @@
 #ifndef QDAQPLUGINLOADER_H
 #define QDAQPLUGINLOADER_H
 
+#include "QDaqGlobal.h"
+
 #include <QStringList>
-#include <QDir>
+#include <QHash>
+#include <QMutex>
+#include <QFileInfo>
 #include <QPluginLoader>
-#include <QLibraryInfo>
-#include <QApplication>
 
+/**
+ * @brief Index of the QDaq plugins found on disk.
+ *
+ * @ingroup Core
+ *
+ * Plugins are searched in the "plugins" folder of the application and
+ * in the "qdaq" folder of the Qt plugins path, in this order.
+ *
+ * The interface of each file is read from its metadata with QPluginLoader::metaData(),
+ * which does not load the library. The IIDs are kept in a cache, stored in
+ * the application's cache folder, and a file is read again only if its
+ * modification time or size has changed.
+ *
+ * The single instance is thread safe.
+ */
+class QDAQ_EXPORT QDaqPluginIndex
+{
+public:
+    /// The index instance, created on first use.
+    static QDaqPluginIndex* instance();
+
+    /// The plugin folders, in search order.
+    QStringList dirs() const;
+    /// File names of the plugins implementing the interface iid.
+    QStringList find(const QString& iid);
+    /// Full path of the first plugin named fileName implementing iid, empty if there is none.
+    QString path(const QString& fileName, const QString& iid);
+
+private:
+    QDaqPluginIndex();
+    ~QDaqPluginIndex();
+
+    struct Entry
+    {
+        qint64 mtime, size;
+        QString iid;
+    };
+    QHash<QString, Entry> entries_;
+    QString cacheFile_;
+    bool dirty_;
+    QMutex mtx_;
+
+    QString iidOf(const QFileInfo& fi);
+    void load();
+    void save();
+};
+
+/**
+ * @brief Finds and loads plugins implementing PluginInterfacePtr.
+ *
+ * @ingroup Core
+ *
+ * Listing plugins does not load them. A library is loaded only by loadPlugin().
+ */
 template<typename PluginInterfacePtr>
 struct QDaqPluginLoader {
 
 public:
 
+    static QString iid()
+    {
+        return QString::fromLatin1(qobject_interface_iid<PluginInterfacePtr>());
+    }
+
     static QStringList findPlugins()
     {
-        QStringList S;
-        int idx = 0;
-
-        // first look at app path
-        QDir pluginsDir = QDir(qApp->applicationDirPath());
-#if defined(Q_OS_WIN)
-        if (pluginsDir.dirName().toLower() == "debug" || pluginsDir.dirName().toLower() == "release")
-            pluginsDir.cdUp();
-#elif defined(Q_OS_MAC)
-        if (pluginsDir.dirName() == "MacOS") {
-            pluginsDir.cdUp();
-            pluginsDir.cdUp();
-            pluginsDir.cdUp();
-        }
-#endif
-        pluginsDir.cd("plugins");
-
-        foreach (QString fileName, pluginsDir.entryList(QDir::Files)) {
-            idx++;
-            //S += QString("  %1. %2: ").arg(idx).arg(fileName);
-            QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
-            QObject *plugin = loader.instance();
-            if (plugin) {
-                PluginInterfacePtr ifc = qobject_cast<PluginInterfacePtr>(plugin);
-                if (ifc) S.push_back(fileName);
-            }
-        }
-
-        // now look at Qt plugin folder
-        pluginsDir = QDir(QLibraryInfo::location(QLibraryInfo::PluginsPath));
-        pluginsDir.cd("qdaq");
-
-        foreach (QString fileName, pluginsDir.entryList(QDir::Files)) {
-            idx++;
-            //S += QString("  %1. %2: ").arg(idx).arg(fileName);
-            QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
-            QObject *plugin = loader.instance();
-            if (plugin) {
-                PluginInterfacePtr ifc = qobject_cast<PluginInterfacePtr>(plugin);
-                if (ifc) S.push_back(fileName);
-            }
-        }
-
-        return S;
+        return QDaqPluginIndex::instance()->find(iid());
     }
 
     static QObject* loadPlugin(const QString& pluginName)
     {
-        // find a plugin with this name
-
-        // first look at app path
-        QDir pluginsDir = QDir(qApp->applicationDirPath());
-#if defined(Q_OS_WIN)
-        if (pluginsDir.dirName().toLower() == "debug" || pluginsDir.dirName().toLower() == "release")
-            pluginsDir.cdUp();
-#elif defined(Q_OS_MAC)
-        if (pluginsDir.dirName() == "MacOS") {
-            pluginsDir.cdUp();
-            pluginsDir.cdUp();
-            pluginsDir.cdUp();
-        }
-#endif
-        pluginsDir.cd("plugins");
-
-        foreach (QString fileName, pluginsDir.entryList(QDir::Files)) {
-            if (fileName==pluginName) {
-                QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
-                QObject *plugin = loader.instance();
-                if (plugin && qobject_cast<PluginInterfacePtr>(plugin))
-                    return plugin;
-                }
-        }
-
-        // now look at Qt plugin folder
-        pluginsDir = QDir(QLibraryInfo::location(QLibraryInfo::PluginsPath));
-        pluginsDir.cd("qdaq");
-
-        foreach (QString fileName, pluginsDir.entryList(QDir::Files)) {
-            if (fileName==pluginName) {
-                QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
-                QObject *plugin = loader.instance();
-                if (plugin && qobject_cast<PluginInterfacePtr>(plugin))
-                    return plugin;
-                }
-        }
+        QString fname = QDaqPluginIndex::instance()->path(pluginName, iid());
+        if (fname.isEmpty()) return 0;
+
+        QPluginLoader loader(fname);
+        QObject *plugin = loader.instance();
+        if (plugin && qobject_cast<PluginInterfacePtr>(plugin))
+            return plugin;
 
         return 0;
     }
@@ -1,4 +1,5 @@
 #include "QDaqDevice.h"
+#include "QDaqChannel.h"
 
 QDaqDevice::QDaqDevice(const QString& name) :
     QDaqJob(name),
@@ -129,6 +130,17 @@ bool QDaqDevice::arm_()
 	if (throwIfOffline()) return armed_ = false;
     else return QDaqJob::arm_();
 }
+bool QDaqDevice::dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const
+{
+    // devices on the same interface must not talk at the same time
+    writes << this;
+    if (ifc_) writes << ifc_.data();
+    for(int i=0; i<inputChannels_.size(); i++)
+        if (inputChannels_[i]) writes << inputChannels_[i];
+    for(int i=0; i<outputChannels_.size(); i++)
+        if (outputChannels_[i]) reads << outputChannels_[i];
+    return QDaqJob::dataAccess(reads,writes);
+}
 // io
 int QDaqDevice::write(const char* msg, int len)
 {
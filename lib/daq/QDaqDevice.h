@@ -81,6 +81,9 @@ protected:
 
 	virtual bool arm_();
 
+    // writes the interface and the input channels, reads the output channels
+    virtual bool dataAccess(QSet<const QDaqObject*>& reads, QSet<const QDaqObject*>& writes) const;
+
     /// Thow QDaqError and script error if called with device offline
 	bool throwIfOffline();
     /// Thow QDaqError and script error if called with device online
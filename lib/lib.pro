@@ -47,7 +47,14 @@ SOURCES += \
     core/bytearrayclass.cpp \
     core/bytearrayprototype.cpp \
     daq/QDaqGpib.cpp \
-    core/QDaqFilter.cpp
+    core/QDaqFilter.cpp \
+    core/QDaqJobPool.cpp \
+    core/QDaqDataPlayer.cpp \
+    core/QDaqScheduler.cpp \
+    core/QDaqNativeJob.cpp \
+    core/QDaqNotifier.cpp \
+    core/QDaqWatchdog.cpp \
+    core/qdaqpluginloader.cpp
 
 HEADERS  += \
     core/QDaqSession.h \
@@ -87,7 +94,15 @@ HEADERS  += \
     daq/QDaqGpibPlugin.h \
     core/QDaqFilter.h \
     core/QDaqFilterPlugin.h \
-    core/qdaqpluginloader.h
+    core/qdaqpluginloader.h \
+    core/QDaqJobPool.h \
+    core/QDaqHistogram.h \
+    core/QDaqDataPlayer.h \
+    core/QDaqScheduler.h \
+    core/QDaqJobPlugin.h \
+    core/QDaqNativeJob.h \
+    core/QDaqNotifier.h \
+    core/QDaqWatchdog.h
 
 
 ## JSedit
@@ -0,0 +1,35 @@
+#-------------------------------------------------
+#
+# Digital FIR/IIR filter plugin
+#
+#-------------------------------------------------
+
+QT       += script
+QT       -= gui
+CONFIG   += plugin
+
+INCLUDEPATH  += ../../lib/daq ../../lib/core
+LIBS += -lgsl
+
+# the per-channel loops are vectorized by the compiler
+unix: QMAKE_CXXFLAGS_RELEASE += -O3
+
+TARGET = $$qtLibraryTarget(qdaqdspfilter)
+TEMPLATE = lib
+DESTDIR = ../../qdaq/plugins
+
+DEFINES += DSPFILTER_LIBRARY
+
+SOURCES += qdaqdspfilter.cpp
+
+HEADERS += qdaqdspfilter.h\
+        dspfilter_global.h \
+    filterdesign.h
+
+unix {
+    target.path = $$[QT_INSTALL_PLUGINS]/qdaq
+    INSTALLS += target
+}
+
+DISTFILES += \
+    dspfilter.json
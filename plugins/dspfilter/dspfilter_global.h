@@ -0,0 +1,12 @@
+#ifndef DSPFILTER_GLOBAL_H
+#define DSPFILTER_GLOBAL_H
+
+#include <QtCore/qglobal.h>
+
+#if defined(DSPFILTER_LIBRARY)
+#  define DSPFILTERSHARED_EXPORT Q_DECL_EXPORT
+#else
+#  define DSPFILTERSHARED_EXPORT Q_DECL_IMPORT
+#endif
+
+#endif // DSPFILTER_GLOBAL_H
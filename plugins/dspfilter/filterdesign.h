@@ -0,0 +1,279 @@
+#ifndef _FILTERDESIGN_H_
+#define _FILTERDESIGN_H_
+
+#include <cmath>
+#include <complex>
+#include <vector>
+#include <algorithm>
+
+/*
+Digital filter design by the classical analog prototype method:
+analog low-pass prototype (zeros, poles, gain) -> frequency transformation
+-> bilinear transform with prewarping -> second order sections.
+
+All frequencies are normalized to the sampling rate (0 < f < 0.5).
+*/
+namespace filterdesign {
+
+enum band_type { lowpass, highpass, bandpass };
+
+typedef std::complex<double> cplx;
+
+struct zpk
+{
+    std::vector<cplx> z, p;
+    double k;
+
+    zpk() : k(1.) {}
+
+    int degree() const { return int(p.size()) - int(z.size()); }
+
+    // Butterworth prototype with cutoff 1 rad/s
+    void butterworth(int n)
+    {
+        z.clear(); p.clear(); k = 1.;
+        for(int m=-n+1; m<n; m+=2)
+            p.push_back(-std::exp(cplx(0., M_PI*m/(2*n))));
+    }
+    // Chebyshev type I prototype with rp dB passband ripple up to 1 rad/s
+    void chebyshev1(int n, double rp)
+    {
+        z.clear(); p.clear();
+        double eps = std::sqrt(std::pow(10., 0.1*rp) - 1.);
+        double mu = std::log(1./eps + std::sqrt(1./(eps*eps) + 1.))/n; // asinh(1/eps)/n
+        cplx prod(1.);
+        for(int m=-n+1; m<n; m+=2)
+        {
+            p.push_back(-std::sinh(cplx(mu, M_PI*m/(2*n))));
+            prod *= -p.back();
+        }
+        k = prod.real();
+        if (!(n & 1)) k /= std::sqrt(1. + eps*eps);
+    }
+
+    void lp2lp(double wo)
+    {
+        for(size_t i=0; i<z.size(); ++i) z[i] *= wo;
+        for(size_t i=0; i<p.size(); ++i) p[i] *= wo;
+        k *= std::pow(wo, degree());
+    }
+    void lp2hp(double wo)
+    {
+        int d = degree();
+        cplx pz(1.), pp(1.);
+        for(size_t i=0; i<z.size(); ++i) { pz *= -z[i]; z[i] = wo/z[i]; }
+        for(size_t i=0; i<p.size(); ++i) { pp *= -p[i]; p[i] = wo/p[i]; }
+        z.insert(z.end(), d, cplx(0.));
+        k *= (pz/pp).real();
+    }
+    void lp2bp(double wo, double bw)
+    {
+        int d = degree();
+        z = bpmap(z, wo, bw);
+        p = bpmap(p, wo, bw);
+        z.insert(z.end(), d, cplx(0.));
+        k *= std::pow(bw, d);
+    }
+    // analog s-plane to z-plane, fs = 1
+    void bilinear()
+    {
+        const double fs2 = 2.;
+        int d = degree();
+        cplx pz(1.), pp(1.);
+        for(size_t i=0; i<z.size(); ++i) { pz *= fs2 - z[i]; z[i] = (fs2 + z[i])/(fs2 - z[i]); }
+        for(size_t i=0; i<p.size(); ++i) { pp *= fs2 - p[i]; p[i] = (fs2 + p[i])/(fs2 - p[i]); }
+        z.insert(z.end(), d, cplx(-1.));
+        k *= (pz/pp).real();
+    }
+
+    static std::vector<cplx> bpmap(const std::vector<cplx>& v, double wo, double bw)
+    {
+        std::vector<cplx> r;
+        for(size_t i=0; i<v.size(); ++i)
+        {
+            cplx a = v[i]*bw/2.;
+            cplx b = std::sqrt(a*a - wo*wo);
+            r.push_back(a + b);
+            r.push_back(a - b);
+        }
+        return r;
+    }
+
+    /*
+    Convert to second order sections, 6 coefficients each: b0 b1 b2 a0 a1 a2.
+    Complex poles are taken in conjugate pairs, ordered away from the unit circle.
+    The zeros of the designs here are real (+-1); each section gets one
+    from each sign when available, so that band-pass sections are (1,0,-1).
+    The gain is put in the first section.
+    */
+    template<class V>
+    void toSos(V& sos) const
+    {
+        const double tol = 1e-10;
+        std::vector<cplx> cp;
+        std::vector<double> rp, zpos, zneg;
+        for(size_t i=0; i<p.size(); ++i)
+        {
+            if (std::abs(p[i].imag()) <= tol*(1. + std::abs(p[i]))) rp.push_back(p[i].real());
+            else if (p[i].imag() > 0.) cp.push_back(p[i]);
+        }
+        for(size_t i=0; i<z.size(); ++i)
+        {
+            if (z[i].real() >= 0.) zpos.push_back(z[i].real());
+            else zneg.push_back(z[i].real());
+        }
+        std::sort(cp.begin(), cp.end(), closer);
+
+        // zeros in the order they are assigned to sections
+        std::vector<double> zs;
+        size_t ip = 0, in = 0;
+        while (ip<zpos.size() || in<zneg.size())
+        {
+            if (ip<zpos.size()) zs.push_back(zpos[ip++]);
+            if (in<zneg.size()) zs.push_back(zneg[in++]);
+        }
+
+        int ns = (int(p.size()) + 1)/2;
+        sos.resize(6*ns);
+        size_t iz = 0, ir = 0;
+        for(int s=0; s<ns; ++s)
+        {
+            double b[3] = {1., 0., 0.}, a[3] = {1., 0., 0.};
+            int np = 2;
+            if (size_t(s) < cp.size())
+            {
+                a[1] = -2.*cp[s].real();
+                a[2] = std::norm(cp[s]);
+            }
+            else if (ir + 1 < rp.size())
+            {
+                a[1] = -(rp[ir] + rp[ir+1]);
+                a[2] = rp[ir]*rp[ir+1];
+                ir += 2;
+            }
+            else
+            {
+                a[1] = -rp[ir++];
+                np = 1;
+            }
+            // as many zeros as poles in this section
+            if (np==2 && iz + 1 < zs.size())
+            {
+                b[1] = -(zs[iz] + zs[iz+1]);
+                b[2] = zs[iz]*zs[iz+1];
+                iz += 2;
+            }
+            else if (iz < zs.size())
+                b[1] = -zs[iz++];
+
+            double g = s==0 ? k : 1.;
+            for(int j=0; j<3; ++j)
+            {
+                sos[6*s + j] = g*b[j];
+                sos[6*s + 3 + j] = a[j];
+            }
+        }
+    }
+
+    static bool closer(const cplx& x, const cplx& y) { return std::abs(x) < std::abs(y); }
+};
+
+// Digital IIR design, order n (band-pass: 2n poles). Returns false for invalid arguments.
+template<class V>
+bool iir(zpk& f, band_type t, double f1, double f2, V& sos)
+{
+    if (!(f1>0. && f1<0.5)) return false;
+    if (t==bandpass && !(f2>f1 && f2<0.5)) return false;
+
+    // prewarped analog frequencies for fs = 1
+    double w1 = 2.*std::tan(M_PI*f1);
+    switch (t)
+    {
+    case lowpass:
+        f.lp2lp(w1);
+        break;
+    case highpass:
+        f.lp2hp(w1);
+        break;
+    case bandpass:
+        {
+            double w2 = 2.*std::tan(M_PI*f2);
+            f.lp2bp(std::sqrt(w1*w2), w2 - w1);
+        }
+        break;
+    }
+    f.bilinear();
+    f.toSos(sos);
+    return true;
+}
+
+template<class V>
+bool butterworth(int n, band_type t, double f1, double f2, V& sos)
+{
+    if (n<1) return false;
+    zpk f;
+    f.butterworth(n);
+    return iir(f, t, f1, f2, sos);
+}
+
+template<class V>
+bool chebyshev1(int n, double rp, band_type t, double f1, double f2, V& sos)
+{
+    if (n<1 || !(rp>0.)) return false;
+    zpk f;
+    f.chebyshev1(n, rp);
+    return iir(f, t, f1, f2, sos);
+}
+
+// ideal low-pass impulse response 2fc sinc(2fc m)
+inline double sinc(double fc, double m)
+{
+    if (m==0.) return 2.*fc;
+    return std::sin(2.*M_PI*fc*m)/(M_PI*m);
+}
+
+/*
+Windowed-sinc FIR design with a Hamming window.
+High-pass and band-pass kernels need an odd number of taps.
+The kernel is scaled to unit gain at 0 (low-pass), 0.5 (high-pass)
+or the band center (band-pass).
+*/
+template<class V>
+bool fir(int ntaps, band_type t, double f1, double f2, V& h)
+{
+    if (ntaps<1 || !(f1>0. && f1<0.5)) return false;
+    if (t!=lowpass && !(ntaps & 1)) return false;
+    if (t==bandpass && !(f2>f1 && f2<0.5)) return false;
+
+    h.resize(ntaps);
+    double M = ntaps - 1;
+    for(int i=0; i<ntaps; ++i)
+    {
+        double m = i - M/2;
+        double w = ntaps>1 ? 0.54 - 0.46*std::cos(2.*M_PI*i/M) : 1.;
+        double v;
+        switch (t)
+        {
+        case lowpass: v = sinc(f1, m); break;
+        case highpass: v = (m==0. ? 1. : 0.) - sinc(f1, m); break;
+        default: v = sinc(f2, m) - sinc(f1, m); break;
+        }
+        h[i] = v*w;
+    }
+
+    // normalize the gain
+    double f0 = t==lowpass ? 0. : (t==highpass ? 0.5 : (f1+f2)/2);
+    double re = 0., im = 0.;
+    for(int i=0; i<ntaps; ++i)
+    {
+        re += h[i]*std::cos(2.*M_PI*f0*i);
+        im -= h[i]*std::sin(2.*M_PI*f0*i);
+    }
+    double g = std::sqrt(re*re + im*im);
+    if (g>0.) for(int i=0; i<ntaps; ++i) h[i] /= g;
+    return true;
+}
+
+} // namespace filterdesign
+
+#endif
@@ -0,0 +1,321 @@
+#include "qdaqdspfilter.h"
+#include "filterdesign.h"
+
+#include "QDaqEnumHelper.h"
+Q_SCRIPT_ENUM(FilterType, QDaqDspFilter)
+
+#include <QMetaEnum>
+
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+
+#include <cstring>
+
+QDaqDspFilter::QDaqDspFilter() :
+    QDaqJob("dspfilter"),
+    nch_(1),
+    type_(None),
+    fftThreshold_(64),
+    pos_(0),
+    nfft_(0),
+    block_(0),
+    fill_(0)
+{
+    init();
+}
+
+void QDaqDspFilter::registerTypes(QScriptEngine* e)
+{
+    qScriptRegisterFilterType(e);
+    QDaqJob::registerTypes(e);
+}
+
+bool QDaqDspFilter::init()
+{
+    int n = nch_;
+    xframe_.fill(0., n);
+    yframe_.fill(0., n);
+
+    hist_.clear();
+    kernelFft_.clear();
+    osIn_.clear();
+    osOut_.clear();
+    work_.clear();
+    coef_.clear();
+    state_.clear();
+    pos_ = nfft_ = block_ = fill_ = 0;
+
+    if (type_==FIR)
+    {
+        uint L = fir_.size();
+        if (fftThreshold_ && L>=fftThreshold_)
+        {
+            // FFT size at least 2L, so that blocks are longer than the kernel
+            nfft_ = 2;
+            while (nfft_ < 2*L) nfft_ <<= 1;
+            block_ = nfft_ - L + 1;
+            kernelFft_.fill(0., nfft_);
+            std::memcpy(kernelFft_.data(), fir_.constData(), L*sizeof(double));
+            gsl_fft_real_radix2_transform(kernelFft_.data(), 1, nfft_);
+            osIn_.fill(0., n*nfft_);
+            osOut_.fill(0., n*block_);
+            work_.fill(0., nfft_);
+        }
+        else hist_.fill(0., 2*L*n);
+    }
+    else if (type_==IIR)
+    {
+        // normalize to a0 = 1
+        int ns = sos_.size()/6;
+        coef_.resize(5*ns);
+        const double* s = sos_.constData();
+        double* c = coef_.data();
+        for(int i=0; i<ns; ++i, s+=6, c+=5)
+        {
+            c[0] = s[0]/s[3];
+            c[1] = s[1]/s[3];
+            c[2] = s[2]/s[3];
+            c[3] = s[4]/s[3];
+            c[4] = s[5]/s[3];
+        }
+        state_.fill(0., 2*ns*n);
+    }
+
+    return true;
+}
+
+bool QDaqDspFilter::operator ()(const double* vin, double* vout)
+{
+    filterFrame(vin,vout);
+    return true;
+}
+
+bool QDaqDspFilter::process(const double* const* in, double* const* out, int nframes)
+{
+    int n = nch_;
+    double* x = xframe_.data();
+    double* y = yframe_.data();
+    for(int k=0; k<nframes; ++k)
+    {
+        for(int c=0; c<n; ++c) x[c] = in[c][k];
+        filterFrame(x,y);
+        for(int c=0; c<n; ++c) out[c][k] = y[c];
+    }
+    return true;
+}
+
+void QDaqDspFilter::filterFrame(const double* x, double* y)
+{
+    switch (type_)
+    {
+    case FIR:
+        if (nfft_) firFft(x,y);
+        else firDirect(x,y);
+        break;
+    case IIR:
+        iir(x,y);
+        break;
+    default:
+        std::memcpy(y, x, nch_*sizeof(double));
+        break;
+    }
+}
+
+void QDaqDspFilter::firDirect(const double* x, double* y)
+{
+    // Each sample row is stored twice, at pos_ and pos_+L, so that
+    // the last L rows are always contiguous: row pos_+L-m holds x[n-m]
+    int n = nch_, L = fir_.size();
+    double* r = hist_.data();
+    double* r0 = r + pos_*n;
+    double* r1 = r0 + L*n;
+    for(int c=0; c<n; ++c) r0[c] = r1[c] = x[c];
+
+    for(int c=0; c<n; ++c) y[c] = 0.;
+    const double* h = fir_.constData();
+    for(int m=0; m<L; ++m)
+    {
+        const double* xm = r1 - m*n;
+        double hm = h[m];
+        for(int c=0; c<n; ++c) y[c] += hm*xm[c];
+    }
+
+    if (++pos_ == (uint)L) pos_ = 0;
+}
+
+void QDaqDspFilter::firFft(const double* x, double* y)
+{
+    // Each channel collects block_ new samples after the last L-1 ones.
+    // Then the circular convolution of the nfft_ samples with the kernel
+    // gives block_ valid outputs, which are returned during the next block.
+    int n = nch_, N = nfft_, B = block_, L = fir_.size();
+    for(int c=0; c<n; ++c)
+    {
+        osIn_[c*N + L - 1 + fill_] = x[c];
+        y[c] = osOut_[c*B + fill_];
+    }
+    if (++fill_ < (uint)B) return;
+    fill_ = 0;
+
+    double* w = work_.data();
+    const double* H = kernelFft_.constData();
+    for(int c=0; c<n; ++c)
+    {
+        double* in = osIn_.data() + c*N;
+        std::memcpy(w, in, N*sizeof(double));
+        gsl_fft_real_radix2_transform(w, 1, N);
+
+        // multiply half-complex spectra: re[i] at i, im[i] at N-i
+        w[0] *= H[0];
+        w[N/2] *= H[N/2];
+        for(int i=1; i<N/2; ++i)
+        {
+            double re = w[i], im = w[N-i];
+            w[i] = re*H[i] - im*H[N-i];
+            w[N-i] = re*H[N-i] + im*H[i];
+        }
+
+        gsl_fft_halfcomplex_radix2_inverse(w, 1, N);
+        std::memcpy(osOut_.data() + c*B, w + L - 1, B*sizeof(double));
+        // keep the last L-1 samples for the next block
+        std::memmove(in, in + B, (L-1)*sizeof(double));
+    }
+}
+
+void QDaqDspFilter::iir(const double* x, double* y)
+{
+    int n = nch_, ns = coef_.size()/5;
+    for(int c=0; c<n; ++c) y[c] = x[c];
+
+    const double* k = coef_.constData();
+    double* z1 = state_.data();
+    for(int s=0; s<ns; ++s, k+=5, z1+=2*n)
+    {
+        double b0 = k[0], b1 = k[1], b2 = k[2], a1 = k[3], a2 = k[4];
+        double* z2 = z1 + n;
+        for(int c=0; c<n; ++c)
+        {
+            double w = y[c];
+            double v = b0*w + z1[c];
+            z1[c] = b1*w - a1*v + z2[c];
+            z2[c] = b2*w - a2*v;
+            y[c] = v;
+        }
+    }
+}
+
+void QDaqDspFilter::setChannels(uint n)
+{
+    if (throwIfArmed() || n==nch_) return;
+    if (n<1)
+    {
+        throwScriptError("There must be at least 1 channel.");
+        return;
+    }
+    nch_ = n;
+    init();
+    emit propertiesChanged();
+}
+
+void QDaqDspFilter::setFir(const QDaqVector& h)
+{
+    if (throwIfArmed()) return;
+    fir_ = h;
+    sos_.clear();
+    type_ = h.isEmpty() ? None : FIR;
+    init();
+    emit propertiesChanged();
+}
+
+void QDaqDspFilter::setSos(const QDaqVector& s)
+{
+    if (throwIfArmed()) return;
+    if (s.size() % 6)
+    {
+        throwScriptError("Sections must have 6 coefficients each.");
+        return;
+    }
+    for(int i=3; i<s.size(); i+=6)
+    {
+        if (s[i]==0.)
+        {
+            throwScriptError("Section coefficient a0 must be non-zero.");
+            return;
+        }
+    }
+    sos_ = s;
+    fir_.clear();
+    type_ = s.isEmpty() ? None : IIR;
+    init();
+    emit propertiesChanged();
+}
+
+void QDaqDspFilter::setFftThreshold(uint n)
+{
+    if (throwIfArmed() || n==fftThreshold_) return;
+    fftThreshold_ = n;
+    init();
+    emit propertiesChanged();
+}
+
+bool QDaqDspFilter::toBand(const QString& s, BandType& b)
+{
+    int i = staticMetaObject.indexOfEnumerator("BandType");
+    int v = staticMetaObject.enumerator(i).keyToValue(s.toLatin1().constData());
+    if (v<0)
+    {
+        throwScriptError("Band must be one of LowPass, HighPass, BandPass.");
+        return false;
+    }
+    b = (BandType)v;
+    return true;
+}
+
+void QDaqDspFilter::butterworth(int order, const QString& band, double f1, double f2)
+{
+    if (throwIfArmed()) return;
+    BandType b;
+    if (!toBand(band,b)) return;
+    QDaqVector s;
+    if (!filterdesign::butterworth(order, (filterdesign::band_type)b, f1, f2, s))
+    {
+        throwScriptError("Invalid order or frequencies.");
+        return;
+    }
+    setSos(s);
+}
+
+void QDaqDspFilter::chebyshev(int order, double ripple, const QString& band, double f1, double f2)
+{
+    if (throwIfArmed()) return;
+    BandType b;
+    if (!toBand(band,b)) return;
+    QDaqVector s;
+    if (!filterdesign::chebyshev1(order, ripple, (filterdesign::band_type)b, f1, f2, s))
+    {
+        throwScriptError("Invalid order, ripple or frequencies.");
+        return;
+    }
+    setSos(s);
+}
+
+void QDaqDspFilter::windowedSinc(int taps, const QString& band, double f1, double f2)
+{
+    if (throwIfArmed()) return;
+    BandType b;
+    if (!toBand(band,b)) return;
+    QDaqVector h;
+    if (!filterdesign::fir(taps, (filterdesign::band_type)b, f1, f2, h))
+    {
+        throwScriptError("Invalid number of taps or frequencies.");
+        return;
+    }
+    setFir(h);
+}
+
+void QDaqDspFilter::clear()
+{
+    if (stageCall("clear")) return;
+    os::auto_lock L(comm_lock);
+    init();
+}
@@ -0,0 +1,144 @@
+#ifndef QDAQDSPFILTER_H
+#define QDAQDSPFILTER_H
+
+#include "dspfilter_global.h"
+
+#include "QDaqFilterPlugin.h"
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+#include <QtPlugin>
+
+/**
+ * @brief A multi-channel FIR / IIR digital filter.
+ *
+ * Each of the #channels inputs is filtered with the same coefficients
+ * to the corresponding output.
+ *
+ * The filter is either FIR, given by the kernel in #fir, or IIR, given
+ * as a cascade of biquad sections in #sos. Setting one of them, or calling
+ * one of the design slots, selects the filter type.
+ *
+ * FIR kernels shorter than #fftThreshold are computed in direct form.
+ * Longer kernels are computed by overlap-save FFT convolution in blocks,
+ * which delays the output by #latency samples.
+ * IIR sections are computed in transposed direct form II.
+ *
+ * The filter states are stored channel-interleaved, so that the inner loops
+ * run over the channels with unit stride and are vectorized by the compiler.
+ * Filtering 64 channels costs a single call per sample (or per block,
+ * see QDaqFilterPlugin::process()).
+ *
+ * Frequencies in the design slots are normalized to the sampling rate,
+ * i.e., 0 < f < 0.5.
+ * Coefficients can only be changed while the filter is disarmed.
+ */
+class DSPFILTERSHARED_EXPORT QDaqDspFilter :
+        public QDaqJob,
+        public QDaqFilterPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID QDaqFilterPlugin_iid FILE "dspfilter.json")
+    Q_INTERFACES(QDaqFilterPlugin)
+
+    /// Number of filtered channels.
+    Q_PROPERTY(uint channels READ channels WRITE setChannels)
+    /// The current filter type, None for pass-through.
+    Q_PROPERTY(FilterType type READ type)
+    /** FIR kernel.
+    y[n] = sum h[m]*x[n-m], h[0] multiplies the newest sample.
+    */
+    Q_PROPERTY(QDaqVector fir READ fir WRITE setFir)
+    /** IIR second order sections.
+    6 coefficients per section, b0 b1 b2 a0 a1 a2.
+    */
+    Q_PROPERTY(QDaqVector sos READ sos WRITE setSos)
+    /** Minimum FIR kernel length for FFT convolution.
+    Set to 0 to always use direct form.
+    */
+    Q_PROPERTY(uint fftThreshold READ fftThreshold WRITE setFftThreshold)
+    /// Output delay in samples due to block convolution.
+    Q_PROPERTY(uint latency READ latency)
+    Q_ENUMS(FilterType)
+    Q_ENUMS(BandType)
+
+public:
+    enum FilterType {
+        None,
+        FIR,
+        IIR
+    };
+    enum BandType {
+        LowPass,
+        HighPass,
+        BandPass
+    };
+
+protected:
+    uint nch_;
+    FilterType type_;
+    QDaqVector fir_, sos_;
+    uint fftThreshold_;
+
+    // direct form FIR: history of 2*taps rows of nch_ samples
+    QDaqVector hist_;
+    uint pos_;
+
+    // overlap-save FIR
+    uint nfft_, block_, fill_;
+    QDaqVector kernelFft_; // half-complex spectrum of the kernel
+    QDaqVector osIn_;      // nch_ input blocks of nfft_
+    QDaqVector osOut_;     // nch_ output blocks of block_
+    QDaqVector work_;
+
+    // IIR: b0 b1 b2 a1 a2 per section, 2 state rows of nch_ per section
+    QDaqVector coef_, state_;
+
+    // frames for process()
+    QDaqVector xframe_, yframe_;
+
+    void filterFrame(const double* x, double* y);
+    void firDirect(const double* x, double* y);
+    void firFft(const double* x, double* y);
+    void iir(const double* x, double* y);
+
+    bool toBand(const QString& s, BandType& b);
+
+public:
+    QDaqDspFilter();
+
+    // getters
+    uint channels() const { return nch_; }
+    FilterType type() const { return type_; }
+    QDaqVector fir() const { return fir_; }
+    QDaqVector sos() const { return sos_; }
+    uint fftThreshold() const { return fftThreshold_; }
+    uint latency() const { return type_==FIR && nfft_ ? block_ : 0; }
+
+    // setters
+    void setChannels(uint n);
+    void setFir(const QDaqVector& h);
+    void setSos(const QDaqVector& s);
+    void setFftThreshold(uint n);
+
+    // QDaqFilterPlugin interface implementation
+    virtual QString errorMsg() { return QString(); }
+    virtual bool init();
+    virtual bool operator()(const double* vin, double* vout);
+    virtual bool process(const double* const* in, double* const* out, int nframes);
+    virtual int nInputChannels() const { return nch_; }
+    virtual int nOutputChannels() const { return nch_; }
+
+    virtual void registerTypes(QScriptEngine* e);
+
+public slots:
+    /// Design a Butterworth filter. Band-pass filters have 2*order poles.
+    void butterworth(int order, const QString& band, double f1, double f2 = 0.);
+    /// Design a Chebyshev type I filter with the given passband ripple in dB.
+    void chebyshev(int order, double ripple, const QString& band, double f1, double f2 = 0.);
+    /// Design a windowed-sinc FIR filter. High- and band-pass need an odd number of taps.
+    void windowedSinc(int taps, const QString& band, double f1, double f2 = 0.);
+    /// Reset the filter state.
+    void clear();
+};
+
+#endif // QDAQDSPFILTER_H
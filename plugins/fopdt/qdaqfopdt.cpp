@@ -32,18 +32,21 @@ bool QDaqFOPDT::operator ()(const double* vin, double* vout)
 
 void QDaqFOPDT::setKp(double k)
 {
+    if (stageProperty("kp",k)) return;
     os::auto_lock L(comm_lock);
     kp_ = k;
     emit propertiesChanged();
 }
 void QDaqFOPDT::setTp(uint t)
 {
+    if (stageProperty("tp",t)) return;
     os::auto_lock L(comm_lock);
     tp_ = t;
     emit propertiesChanged();
 }
 void QDaqFOPDT::setTd(uint t)
 {
+    if (stageProperty("td",t)) return;
     os::auto_lock L(comm_lock);
     td_ = t;
     init();
@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Native job plugin: comparators with hysteresis
+#
+#-------------------------------------------------
+
+QT       += script
+QT       -= gui
+CONFIG   += plugin
+
+INCLUDEPATH  += ../../lib/daq ../../lib/core
+
+TARGET = $$qtLibraryTarget(qdaqhysteresis)
+TEMPLATE = lib
+DESTDIR = ../../qdaq/plugins
+
+DEFINES += HYSTERESIS_LIBRARY
+
+SOURCES += qdaqhysteresis.cpp
+
+HEADERS += qdaqhysteresis.h\
+        hysteresis_global.h
+
+unix {
+    target.path = $$[QT_INSTALL_PLUGINS]/qdaq
+    INSTALLS += target
+}
+
+DISTFILES += \
+    hysteresis.json
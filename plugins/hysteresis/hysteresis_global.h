@@ -0,0 +1,12 @@
+#ifndef HYSTERESIS_GLOBAL_H
+#define HYSTERESIS_GLOBAL_H
+
+#include <QtCore/qglobal.h>
+
+#if defined(HYSTERESIS_LIBRARY)
+#  define HYSTERESISSHARED_EXPORT Q_DECL_EXPORT
+#else
+#  define HYSTERESISSHARED_EXPORT Q_DECL_IMPORT
+#endif
+
+#endif // HYSTERESIS_GLOBAL_H
@@ -0,0 +1,52 @@
+#include "qdaqhysteresis.h"
+
+QDaqHysteresis::QDaqHysteresis() :
+    QDaqJob("hysteresis"),
+    low_(0.),
+    high_(1.)
+{
+}
+
+bool QDaqHysteresis::init(int nInputs, int nOutputs)
+{
+    if (nInputs != nOutputs)
+    {
+        errorMsg_ = "The number of input and output channels must be equal.";
+        return false;
+    }
+    state_.fill(-1,nInputs);
+    errorMsg_.clear();
+    return true;
+}
+
+bool QDaqHysteresis::run(const QDaqJobInput* in, QDaqJobOutput* out)
+{
+    for(int i=0; i<state_.size(); ++i)
+    {
+        int s = state_[i];
+        double v = in[i].value;
+        if (v > high_) s = 1;
+        else if (v < low_) s = 0;
+        else if (s < 0) s = v > 0.5*(low_ + high_) ? 1 : 0;
+
+        out[i].value = s;
+        out[i].push = s != state_[i];
+        state_[i] = s;
+    }
+    return true;
+}
+
+void QDaqHysteresis::setLow(double v)
+{
+    if (stageProperty("low",v)) return;
+    os::auto_lock L(comm_lock);
+    low_ = v;
+    emit propertiesChanged();
+}
+void QDaqHysteresis::setHigh(double v)
+{
+    if (stageProperty("high",v)) return;
+    os::auto_lock L(comm_lock);
+    high_ = v;
+    emit propertiesChanged();
+}
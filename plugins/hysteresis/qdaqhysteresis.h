@@ -0,0 +1,52 @@
+#ifndef QDAQHYSTERESIS_H
+#define QDAQHYSTERESIS_H
+
+#include "hysteresis_global.h"
+
+#include "QDaqJobPlugin.h"
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+#include <QtPlugin>
+
+/**
+ * @brief Comparators with hysteresis, a QDaqJobPlugin.
+ *
+ * Each output follows the corresponding input: it becomes 1 when
+ * the input rises above high and 0 when it falls below low.
+ * The output is pushed only when it changes.
+ */
+class HYSTERESISSHARED_EXPORT QDaqHysteresis :
+        public QDaqJob,
+        public QDaqJobPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID QDaqJobPlugin_iid FILE "hysteresis.json")
+    Q_INTERFACES(QDaqJobPlugin)
+
+    Q_PROPERTY(double low READ low WRITE setLow)
+    Q_PROPERTY(double high READ high WRITE setHigh)
+
+    double low_, high_;
+    QVector<int> state_; // -1 : unknown
+
+    QString errorMsg_;
+
+public:
+    QDaqHysteresis();
+
+    // getters
+    double low() const { return low_; }
+    double high() const { return high_; }
+
+    // setters
+    void setLow(double v);
+    void setHigh(double v);
+
+    // QDaqJobPlugin interface implementation
+    virtual QString errorMsg() { return errorMsg_; }
+    virtual bool accepts(int nInputs, int nOutputs) const { return nInputs == nOutputs; }
+    virtual bool init(int nInputs, int nOutputs);
+    virtual bool run(const QDaqJobInput* in, QDaqJobOutput* out);
+};
+
+#endif // QDAQHYSTERESIS_H
@@ -17,17 +17,19 @@ QDaqInterpolator::QDaqInterpolator() :
     QDaqJob("interpolator"),
     type_(None),
     interpolator_(0),
-    accel_(0),
     xa(0,1),
-    ya(0,1)
+    ya(0,1),
+    gridSize_(0),
+    gridX0_(0.),
+    gridScale_(0.)
 {
-    accel_ = gsl_interp_accel_alloc ();
+    accel_.push_back(gsl_interp_accel_alloc ());
 }
 
 QDaqInterpolator::~QDaqInterpolator(void)
 {
     if (interpolator_) gsl_interp_free (interpolator_);
-    gsl_interp_accel_free (accel_);
+    foreach(gsl_interp_accel* a, accel_) gsl_interp_accel_free (a);
 }
 
 void QDaqInterpolator::registerTypes(QScriptEngine* e)
@@ -47,18 +49,53 @@ bool QDaqInterpolator::init()
         interpolator_ = gsl_interp_alloc(InterpolationObjects[it],n);
         gsl_interp_init(interpolator_, xa.begin(), ya.begin(), n);
     }
+    foreach(gsl_interp_accel* a, accel_) gsl_interp_accel_reset (a);
+
+    // resample on the uniform grid
+    grid_.clear();
+    if (interpolator_ && gridSize_>1)
+    {
+        double x0 = xa[0], x1 = xa[n-1], h = (x1 - x0)/(gridSize_ - 1);
+        grid_.resize(gridSize_);
+        for(uint i=0; i<gridSize_-1; ++i)
+            grid_[i] = gsl_interp_eval(interpolator_, xa.begin(), ya.begin(), x0 + i*h, accel_[0]);
+        grid_[gridSize_-1] = ya[n-1];
+        gridX0_ = x0;
+        gridScale_ = (gridSize_ - 1)/(x1 - x0);
+        gsl_interp_accel_reset (accel_[0]);
+    }
     return true;
 }
 
 bool QDaqInterpolator::operator()(const double* vin, double* vout)
 {
-    if (interpolator_)
+    int nch = accel_.size();
+    if (!grid_.isEmpty())
     {
-        double val;
-        int ret = gsl_interp_eval_e(interpolator_, xa.begin(), ya.begin(), *vin, accel_, &val);
-        *vout = (ret==0) ? val : *vin;
+        const double* g = grid_.constData();
+        double umax = grid_.size() - 1;
+        for(int k=0; k<nch; ++k)
+        {
+            double x = vin[k], u = (x - gridX0_)*gridScale_;
+            if (u>=0. && u<=umax)
+            {
+                int i = (int)u;
+                if (i==(int)umax) i--;
+                vout[k] = g[i] + (u - i)*(g[i+1] - g[i]);
+            }
+            else vout[k] = x;
+        }
     }
-    else *vout = *vin;
+    else if (interpolator_)
+    {
+        for(int k=0; k<nch; ++k)
+        {
+            double val;
+            int ret = gsl_interp_eval_e(interpolator_, xa.begin(), ya.begin(), vin[k], accel_[k], &val);
+            vout[k] = (ret==0) ? val : vin[k];
+        }
+    }
+    else for(int k=0; k<nch; ++k) vout[k] = vin[k];
 
     return true;
 }
@@ -73,6 +110,29 @@ void QDaqInterpolator::setType(InterpolationType t)
     }
 }
 
+void QDaqInterpolator::setGridSize(uint n)
+{
+    if (!throwIfArmed() && gridSize_ != n)
+    {
+        gridSize_ = n;
+        init();
+        emit propertiesChanged();
+    }
+}
+
+void QDaqInterpolator::setChannels(uint n)
+{
+    if (throwIfArmed() || n==(uint)accel_.size()) return;
+    if (n<1)
+    {
+        throwScriptError("There must be at least 1 channel.");
+        return;
+    }
+    while ((uint)accel_.size() > n) gsl_interp_accel_free (accel_.takeLast());
+    while ((uint)accel_.size() < n) accel_.push_back(gsl_interp_accel_alloc ());
+    emit propertiesChanged();
+}
+
 void QDaqInterpolator::setTable(const QDaqVector& x, const QDaqVector& y)
 {
     if (throwIfArmed()) return;
@@ -19,6 +19,16 @@ class INTERPOLATORSHARED_EXPORT QDaqInterpolator :
     Q_INTERFACES(QDaqFilterPlugin)
 
     Q_PROPERTY(InterpolationType type READ type WRITE setType)
+    /** Number of points of a uniform lookup grid.
+    If larger than 1, the interpolation is evaluated at init() on a uniform grid
+    spanning the table and each input is then computed by direct indexing and
+    linear interpolation between grid points, in constant time independent
+    of the table size. The grid should be dense enough for the required accuracy.
+    0 (default) evaluates the interpolation directly.
+    */
+    Q_PROPERTY(uint gridSize READ gridSize WRITE setGridSize)
+    /// Number of inputs, all interpolated with the same table to the corresponding outputs.
+    Q_PROPERTY(uint channels READ channels WRITE setChannels)
     Q_ENUMS(InterpolationType)
 
 public:
@@ -32,10 +42,16 @@ public:
 protected:
     InterpolationType type_;
     gsl_interp* interpolator_;
-    gsl_interp_accel* accel_;
+    // one accelerator per channel
+    QVector<gsl_interp_accel*> accel_;
 
     QDaqVector xa, ya;
 
+    // uniform grid
+    uint gridSize_;
+    QDaqVector grid_;
+    double gridX0_, gridScale_;
+
 public:
     QDaqInterpolator();
     virtual ~QDaqInterpolator();
@@ -44,11 +60,15 @@ public:
     virtual QString errorMsg() { return QString(); }
     virtual bool init();
     virtual bool operator()(const double* vin, double* vout);
-    virtual int nInputChannels() const { return 1; }
-    virtual int nOutputChannels() const { return 1; }
+    virtual int nInputChannels() const { return accel_.size(); }
+    virtual int nOutputChannels() const { return accel_.size(); }
 
     InterpolationType type() const { return type_; }
     void setType(InterpolationType t);
+    uint gridSize() const { return gridSize_; }
+    void setGridSize(uint n);
+    uint channels() const { return accel_.size(); }
+    void setChannels(uint n);
 
     virtual void registerTypes(QScriptEngine* e);
 
@@ -33,4 +33,78 @@ struct linefit
 	}
 };
 
+/*
+Fit to y = a + bx over a sliding window, updated in O(1) per sample.
+
+The means and the centered sums Sxx, Syy, Sxy are updated with
+Welford-type formulas, which do not lose precision when the data
+have a large offset. recompute() evaluates them exactly in two passes;
+it is used periodically to clear accumulated rounding errors.
+*/
+template<class T>
+struct slidingfit
+{
+    unsigned int n;
+    T mx, my, sxx, syy, sxy;
+
+    slidingfit() { clear(); }
+
+    void clear()
+    {
+        n = 0;
+        mx = my = sxx = syy = sxy = T(0);
+    }
+    void add(T x, T y)
+    {
+        n++;
+        T dx = x - mx, dy = y - my;
+        mx += dx/n;
+        my += dy/n;
+        sxx += dx*(x - mx);
+        syy += dy*(y - my);
+        sxy += dx*(y - my);
+    }
+    void remove(T x, T y)
+    {
+        if (n<2) { clear(); return; }
+        n--;
+        T dx = x - mx, dy = y - my;
+        mx -= dx/n;
+        my -= dy/n;
+        sxx -= dx*(x - mx);
+        syy -= dy*(y - my);
+        sxy -= dx*(y - my);
+    }
+    template<class V>
+    void recompute(const V& x, const V& y, int ndata)
+    {
+        clear();
+        if (ndata<1) return;
+        int i;
+        for (i=0; i<ndata; i++) { mx += x[i]; my += y[i]; }
+        n = ndata;
+        mx /= n;
+        my /= n;
+        for (i=0; i<ndata; i++) {
+            T dx = x[i] - mx, dy = y[i] - my;
+            sxx += dx*dx;
+            syy += dy*dy;
+            sxy += dx*dy;
+        }
+    }
+
+    // slope, intercept
+    T b() const { return sxx>T(0) ? sxy/sxx : T(0); }
+    T a() const { return my - b()*mx; }
+    // coefficient of determination
+    T r2() const { return (sxx>T(0) && syy>T(0)) ? sxy*sxy/(sxx*syy) : T(1); }
+    // standard deviation of the residuals
+    T sigma() const
+    {
+        if (n<3) return T(0);
+        T sse = syy - b()*sxy;
+        return sse>T(0) ? std::sqrt(sse/(n-2)) : T(0);
+    }
+};
+
 #endif
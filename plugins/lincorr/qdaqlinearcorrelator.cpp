@@ -1,9 +1,10 @@
 #include "qdaqlinearcorrelator.h"
-#include "linefit.h"
 
 QDaqLinearCorrelator::QDaqLinearCorrelator() : QDaqJob("lincorr"),
     size_(2),
-    len_(0)
+    len_(0),
+    statistics_(false),
+    sinceRecompute_(0)
 {
     x_.alloc(2);
     y_.alloc(2);
@@ -13,40 +14,74 @@ void QDaqLinearCorrelator::setSize(uint sz)
 {
     if ((sz!=size()) && sz>1)
     {
+        if (stageProperty("size",sz)) return;
         {
             os::auto_lock L(comm_lock);
             x_.alloc(sz);
             y_.alloc(sz);
             size_ = sz;
             len_ = 0;
+            fit_.clear();
+            sinceRecompute_ = 0;
         }
         emit propertiesChanged();
     }
 }
 
+void QDaqLinearCorrelator::setStatistics(bool on)
+{
+    if (throwIfArmed() || on==statistics_) return;
+    statistics_ = on;
+    emit propertiesChanged();
+}
+
 bool QDaqLinearCorrelator::init()
 {
     len_ = 0;
+    fit_.clear();
+    sinceRecompute_ = 0;
     return true;
 }
 
 bool QDaqLinearCorrelator::operator ()(const double* vin, double* vout)
 {
-    x_ << vin[0];
-    y_ << vin[1];
-    if (len_ < size_) len_++;
+    double x = vin[0], y = vin[1];
+
+    // the oldest sample leaves the window
+    if (len_ == size_) fit_.remove(x_[len_-1], y_[len_-1]);
+    else len_++;
+
+    x_ << x;
+    y_ << y;
+
+    if (++sinceRecompute_ >= size_)
+    {
+        fit_.recompute(x_,y_,len_);
+        sinceRecompute_ = 0;
+    }
+    else fit_.add(x,y);
+
+    double a = 0., b = 0.;
     if (len_>1)
     {
-        linefit<double> fitobj(x_,y_,len_);
-        vout[0] = fitobj.a;
-        vout[1] = fitobj.b;
-    } else vout[0] = vout[1] = 0.;
+        a = fit_.a();
+        b = fit_.b();
+    }
+    vout[0] = a;
+    vout[1] = b;
+    if (statistics_)
+    {
+        vout[2] = len_>1 ? fit_.r2() : 0.;
+        vout[3] = fit_.sigma();
+        vout[4] = len_>1 ? y - (a + b*x) : 0.;
+    }
 
     return true;
 }
 
 void QDaqLinearCorrelator::clear()
 {
+    if (stageCall("clear")) return;
     os::auto_lock L(comm_lock);
-    len_ = 0;
+    init();
 }
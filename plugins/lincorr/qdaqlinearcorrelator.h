@@ -6,6 +6,7 @@
 #include "QDaqFilterPlugin.h"
 #include "QDaqJob.h"
 #include "QDaqTypes.h"
+#include "linefit.h"
 #include <QtPlugin>
 
 class LINCORRSHARED_EXPORT QDaqLinearCorrelator :
@@ -24,10 +25,20 @@ class LINCORRSHARED_EXPORT QDaqLinearCorrelator :
     Actual number of past (x,y) data points currently stored in the buffer.
     */
     Q_PROPERTY(uint length READ length)
+    /** Output residual statistics.
+    If true there are 3 more outputs: the coefficient of determination r^2,
+    the standard deviation of the residuals and the residual of the last sample.
+    */
+    Q_PROPERTY(bool statistics READ statistics WRITE setStatistics)
 
     math::circular_buffer<double> x_,y_;
 
     uint size_, len_;
+    bool statistics_;
+
+    // sliding sums, recomputed exactly every size_ samples
+    slidingfit<double> fit_;
+    uint sinceRecompute_;
 
 public:
     QDaqLinearCorrelator();
@@ -35,16 +46,18 @@ public:
     // getters
     uint size() const { return size_; }
     uint length() const { return len_; }
+    bool statistics() const { return statistics_; }
 
     // setters
     void setSize(uint sz);
+    void setStatistics(bool on);
 
     // QDaqFilterPlugin interface implementation
     virtual QString errorMsg() { return QString(); }
     virtual bool init();
     virtual bool operator()(const double* vin, double* vout);
     virtual int nInputChannels() const { return 2; }
-    virtual int nOutputChannels() const { return 2; }
+    virtual int nOutputChannels() const { return statistics_ ? 5 : 2; }
 
 public slots:
     void clear();
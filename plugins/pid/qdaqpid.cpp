@@ -39,24 +39,28 @@ bool QDaqPid::operator ()(const double* vin, double *vout)
 // setters
 void QDaqPid::setAutoMode(bool on)
 {
+    if (stageProperty("autoMode",on)) return;
     os::auto_lock L(comm_lock);
     auto_ = on;
     emit propertiesChanged();
 }
 void QDaqPid::setAutoTune(bool on)
 {
+    if (stageProperty("autoTune",on)) return;
     os::auto_lock L(comm_lock);
     autotune_ = on;
     emit propertiesChanged();
 }
 void QDaqPid::setMaxPower(double v)
 {
+    if (stageProperty("maxPower",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_umax(v);
     emit propertiesChanged();
 }
 void QDaqPid::setPower(double v)
 {
+    if (stageProperty("power",v)) return;
     if (!auto_)
     {
         os::auto_lock L(comm_lock);
@@ -66,54 +70,63 @@ void QDaqPid::setPower(double v)
 }
 void QDaqPid::setSamplingPeriod(double v)
 {
+    if (stageProperty("samplingPeriod",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_h(v);
     emit propertiesChanged();
 }
 void QDaqPid::setSetPoint(double v)
 {
+    if (stageProperty("setPoint",v)) return;
     os::auto_lock L(comm_lock);
     Ts_ = v;
     emit propertiesChanged();
 }
 void QDaqPid::setGain(double v)
 {
+    if (stageProperty("gain",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_k(v);
     emit propertiesChanged();
 }
 void QDaqPid::setTi(double v)
 {
+    if (stageProperty("Ti",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_ti(v);
     emit propertiesChanged();
 }
 void QDaqPid::setTd(double v)
 {
+    if (stageProperty("Td",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_td(v);
     emit propertiesChanged();
 }
 void QDaqPid::setTr(double v)
 {
+    if (stageProperty("Tr",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_tr(v);
     emit propertiesChanged();
 }
 void QDaqPid::setNd(uint v)
 {
+    if (stageProperty("Nd",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_N(v);
     emit propertiesChanged();
 }
 void QDaqPid::setBeta(double v)
 {
+    if (stageProperty("beta",v)) return;
     os::auto_lock L(comm_lock);
     pid.set_b(v);
     emit propertiesChanged();
 }
 void QDaqPid::setRelayStep(double v)
 {
+    if (stageProperty("relayStep",v)) return;
     os::auto_lock L(comm_lock);
     tuner.set_step(v);
     emit propertiesChanged();
@@ -124,12 +137,14 @@ void QDaqPid::setRelayOffset(double v)
 }
 void QDaqPid::setRelayThreshold(double v)
 {
+    if (stageProperty("relayThreshold",v)) return;
     os::auto_lock L(comm_lock);
     tuner.set_dy(v);
     emit propertiesChanged();
 }
 void QDaqPid::setRelayIterations(int v)
 {
+    if (stageProperty("relayIterations",v)) return;
     os::auto_lock L(comm_lock);
     tuner.set_count(v);
     emit propertiesChanged();
@@ -118,6 +118,8 @@ public:
 	void set_step(T v) { step = v; }
 	void set_dy(T v) { dy = v; }
 	void set_count(int v) { count = v; }
+	// output level around which the relay oscillates
+	void set_cv0(T v) { cv0 = v; }
 };
 
 #endif
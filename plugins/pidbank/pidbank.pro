@@ -0,0 +1,34 @@
+#-------------------------------------------------
+#
+# PID controller bank plugin
+#
+#-------------------------------------------------
+
+QT       += script
+QT       -= gui
+CONFIG   += plugin
+
+INCLUDEPATH  += ../../lib/daq ../../lib/core ../pid
+
+# the per-zone loops are vectorized by the compiler
+unix: QMAKE_CXXFLAGS_RELEASE += -O3
+
+TARGET = $$qtLibraryTarget(qdaqpidbank)
+TEMPLATE = lib
+DESTDIR = ../../qdaq/plugins
+
+DEFINES += PIDBANK_LIBRARY
+
+SOURCES += qdaqpidbank.cpp
+
+HEADERS += qdaqpidbank.h\
+        pidbank_global.h \
+    ../pid/relaytuner.h
+
+unix {
+    target.path = $$[QT_INSTALL_PLUGINS]/qdaq
+    INSTALLS += target
+}
+
+DISTFILES += \
+    pidbank.json
@@ -0,0 +1,12 @@
+#ifndef PIDBANK_GLOBAL_H
+#define PIDBANK_GLOBAL_H
+
+#include <QtCore/qglobal.h>
+
+#if defined(PIDBANK_LIBRARY)
+#  define PIDBANKSHARED_EXPORT Q_DECL_EXPORT
+#else
+#  define PIDBANKSHARED_EXPORT Q_DECL_IMPORT
+#endif
+
+#endif // PIDBANK_GLOBAL_H
@@ -0,0 +1,406 @@
+#include "qdaqpidbank.h"
+
+#include <cstring>
+
+// resize a per-zone vector, new zones get the default value
+static void resizeZones(QDaqVector& v, int n, double def)
+{
+    int m = v.size();
+    v.resize(n);
+    for(int i=m; i<n; ++i) v[i] = def;
+}
+
+QDaqPidBank::QDaqPidBank() : QDaqJob("pidbank"),
+    n_(0),
+    h_(1.),
+    auto_(false),
+    autotune_(false),
+    needSlow_(true),
+    tuneIdx_(0)
+{
+    setZones(1);
+}
+
+bool QDaqPidBank::init()
+{
+    auto_ = false;
+    autotune_ = false;
+    resetStates();
+    return true;
+}
+
+void QDaqPidBank::resetStates()
+{
+    ui_.fill(0.,n_);
+    ud_.fill(0.,n_);
+    pvp_.fill(0.,n_);
+    cvp_.fill(0.,n_);
+    cv_.fill(0.,n_);
+    atp_.fill(false,n_);
+    changed_.fill(false,n_);
+    needSlow_ = true;
+}
+
+void QDaqPidBank::updatePar()
+{
+    // as isa_pid::update_par() for each zone
+    a1_.resize(n_);
+    a2_.resize(n_);
+    b1_.resize(n_);
+    b2_.resize(n_);
+    for(int i=0; i<n_; ++i)
+    {
+        double N = nd_[i], den = td_[i] + N*h_;
+        a1_[i] = ti_[i]!=0. ? k_[i]*h_/ti_[i] : 0.;
+        a2_[i] = tr_[i]!=0. ? h_/tr_[i] : 0.;
+        b1_[i] = den!=0. ? td_[i]/den : 0.;
+        b2_[i] = k_[i]*N*b1_[i];
+    }
+}
+
+bool QDaqPidBank::zoneVector(const QDaqVector& v, QDaqVector& x)
+{
+    if (v.size()==1) x.fill(v[0],n_);
+    else if (v.size()==n_) x = v;
+    else
+    {
+        throwScriptError("Vector must have 1 element or 1 per zone.");
+        return false;
+    }
+    return true;
+}
+
+void QDaqPidBank::assign(QDaqVector& dst, const QDaqVector& x)
+{
+    // zones with changed parameters make a bumpless switch
+    for(int i=0; i<n_; ++i)
+    {
+        if (dst[i]!=x[i])
+        {
+            changed_[i] = true;
+            needSlow_ = true;
+        }
+    }
+    dst = x;
+    updatePar();
+}
+
+bool QDaqPidBank::operator ()(const double* vin, double* vout)
+{
+    // relay auto-tuning of one zone, which is in manual mode meanwhile
+    int j = tuningZone();
+    if (j>=0)
+    {
+        bool at = true;
+        double c = cv_[j];
+        bool ret = tuner_(sp_[j], vin[j], c, at);
+        cv_[j] = c;
+        if (ret)
+        {
+            kc_[j] = tuner_.get_kc();
+            tc_[j] = tuner_.get_tc()*h_;
+            tuneIdx_++;
+            if (tuneIdx_ < tuneQueue_.size()) startTuning();
+            else autotune_ = false;
+            // the zone returns to its mode in this cycle
+            j = -1;
+            needSlow_ = true;
+            emit propertiesChanged();
+        }
+    }
+
+    if (needSlow_) slowPass(vin, j);
+    else
+    {
+        double cj = j>=0 ? cv_[j] : 0.;
+        fastPass(vin);
+        if (j>=0)
+        {
+            // manual mode for the tuned zone
+            double up = k_[j]*(b_[j]*sp_[j] - vin[j]);
+            cv_[j] = cvp_[j] = cj;
+            ui_[j] = cj - up - ud_[j];
+            atp_[j] = false;
+        }
+    }
+
+    std::memcpy(vout, cv_.constData(), n_*sizeof(double));
+    return true;
+}
+
+void QDaqPidBank::fastPass(const double* pv)
+{
+    // isa_pid::operator() without mode or parameter changes
+    int n = n_;
+    const double* sp = sp_.constData();
+    const double* k = k_.constData();
+    const double* b = b_.constData();
+    const double* umax = umax_.constData();
+    const double* a1 = a1_.constData();
+    const double* a2 = a2_.constData();
+    const double* b1 = b1_.constData();
+    const double* b2 = b2_.constData();
+    double* ui = ui_.data();
+    double* ud = ud_.data();
+    double* pvp = pvp_.data();
+    double* cvp = cvp_.data();
+    double* cv = cv_.data();
+
+    if (auto_)
+    {
+        for(int i=0; i<n; ++i)
+        {
+            double x = pv[i];
+            double up = k[i]*(b[i]*sp[i] - x);
+            double d = b1[i]*ud[i] - b2[i]*(x - pvp[i]);
+            double v = up + ui[i] + d;
+            double u = v>umax[i] ? umax[i] : (v<0. ? 0. : v);
+            ui[i] += a1[i]*(sp[i] - x) + a2[i]*(u - v);
+            ud[i] = d;
+            cv[i] = cvp[i] = u;
+            pvp[i] = x;
+        }
+    }
+    else
+    {
+        for(int i=0; i<n; ++i)
+        {
+            double x = pv[i];
+            double up = k[i]*(b[i]*sp[i] - x);
+            double d = b1[i]*ud[i] - b2[i]*(x - pvp[i]);
+            ui[i] = cv[i] - up - d;
+            ud[i] = d;
+            cvp[i] = cv[i];
+            pvp[i] = x;
+        }
+    }
+}
+
+void QDaqPidBank::slowPass(const double* pv, int jtune)
+{
+    // isa_pid::operator() for each zone
+    for(int i=0; i<n_; ++i)
+    {
+        bool automode = auto_ && i!=jtune;
+        double sp = sp_[i], x = pv[i];
+
+        double up = k_[i]*(b_[i]*sp - x);
+        ud_[i] = b1_[i]*ud_[i] - b2_[i]*(x - pvp_[i]);
+
+        if (changed_[i])
+        {
+            ui_[i] = (a1_[i]>0.) ? cvp_[i] - up - ud_[i] : 0.;
+            changed_[i] = false;
+        }
+        if (automode && !atp_[i] && a1_[i]<=0.) ui_[i] = 0.;
+
+        double v = up + ui_[i] + ud_[i];
+        double u = v>umax_[i] ? umax_[i] : (v<0. ? 0. : v);
+
+        if (automode)
+        {
+            cv_[i] = u;
+            ui_[i] += a1_[i]*(sp - x) + a2_[i]*(u - v);
+        }
+        else ui_[i] = cv_[i] - up - ud_[i];
+
+        pvp_[i] = x;
+        cvp_[i] = cv_[i];
+        atp_[i] = automode;
+    }
+    needSlow_ = false;
+}
+
+void QDaqPidBank::startTuning()
+{
+    // a fresh relay around the current output of the zone
+    autotuner<double> t;
+    t.set_step(tuner_.get_step());
+    t.set_dy(tuner_.get_dy());
+    t.set_count(tuner_.get_count());
+    t.set_cv0(cv_[tuneQueue_[tuneIdx_]]);
+    tuner_ = t;
+}
+
+// setters
+void QDaqPidBank::setZones(uint n)
+{
+    if (throwIfArmed() || (int)n==n_) return;
+    if (n<1)
+    {
+        throwScriptError("There must be at least 1 zone.");
+        return;
+    }
+    n_ = n;
+    // defaults of isa_pid
+    resizeZones(sp_,n_,0.);
+    resizeZones(umax_,n_,1.);
+    resizeZones(k_,n_,1.);
+    resizeZones(ti_,n_,0.);
+    resizeZones(td_,n_,0.);
+    resizeZones(tr_,n_,0.);
+    resizeZones(nd_,n_,5.);
+    resizeZones(b_,n_,1.);
+    resizeZones(kc_,n_,0.);
+    resizeZones(tc_,n_,0.);
+    updatePar();
+    resetStates();
+    emit propertiesChanged();
+}
+void QDaqPidBank::setSamplingPeriod(double v)
+{
+    if (stageProperty("samplingPeriod",v)) return;
+    os::auto_lock L(comm_lock);
+    h_ = v;
+    changed_.fill(true);
+    needSlow_ = true;
+    updatePar();
+    emit propertiesChanged();
+}
+void QDaqPidBank::setAutoMode(bool on)
+{
+    if (stageProperty("autoMode",on)) return;
+    os::auto_lock L(comm_lock);
+    auto_ = on;
+    needSlow_ = true;
+    emit propertiesChanged();
+}
+void QDaqPidBank::setSetPoint(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("setPoint",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    sp_ = x;
+    emit propertiesChanged();
+}
+void QDaqPidBank::setPower(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("power",QVariant::fromValue(x))) return;
+    if (!auto_)
+    {
+        os::auto_lock L(comm_lock);
+        cv_ = x;
+        emit propertiesChanged();
+    }
+}
+void QDaqPidBank::setMaxPower(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("maxPower",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    umax_ = x;
+    emit propertiesChanged();
+}
+void QDaqPidBank::setGain(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("gain",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    assign(k_,x);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setTi(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("Ti",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    assign(ti_,x);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setTd(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("Td",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    assign(td_,x);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setTr(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("Tr",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    assign(tr_,x);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setNd(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("Nd",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    assign(nd_,x);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setBeta(const QDaqVector& v)
+{
+    QDaqVector x;
+    if (!zoneVector(v,x)) return;
+    if (stageProperty("beta",QVariant::fromValue(x))) return;
+    os::auto_lock L(comm_lock);
+    assign(b_,x);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setAutoTune(bool on)
+{
+    if (stageProperty("autoTune",on)) return;
+    os::auto_lock L(comm_lock);
+    if (on)
+    {
+        tuneQueue_.clear();
+        if (tuneZones_.isEmpty())
+            for(int i=0; i<n_; ++i) tuneQueue_ << i;
+        else
+            foreach(double z, tuneZones_) if (z<n_) tuneQueue_ << (int)z;
+        tuneIdx_ = 0;
+        if (tuneQueue_.isEmpty()) on = false;
+        else startTuning();
+    }
+    autotune_ = on;
+    needSlow_ = true;
+    emit propertiesChanged();
+}
+void QDaqPidBank::setTuneZones(const QDaqVector& v)
+{
+    foreach(double z, v)
+    {
+        if (z<0 || z>=n_ || z!=(int)z)
+        {
+            throwScriptError("Invalid zone index.");
+            return;
+        }
+    }
+    if (stageProperty("tuneZones",QVariant::fromValue(v))) return;
+    os::auto_lock L(comm_lock);
+    tuneZones_ = v;
+    emit propertiesChanged();
+}
+void QDaqPidBank::setRelayStep(double v)
+{
+    if (stageProperty("relayStep",v)) return;
+    os::auto_lock L(comm_lock);
+    tuner_.set_step(v);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setRelayThreshold(double v)
+{
+    if (stageProperty("relayThreshold",v)) return;
+    os::auto_lock L(comm_lock);
+    tuner_.set_dy(v);
+    emit propertiesChanged();
+}
+void QDaqPidBank::setRelayIterations(int v)
+{
+    if (stageProperty("relayIterations",v)) return;
+    os::auto_lock L(comm_lock);
+    tuner_.set_count(v);
+    emit propertiesChanged();
+}
@@ -0,0 +1,147 @@
+#ifndef QDAQPIDBANK_H
+#define QDAQPIDBANK_H
+
+#include "pidbank_global.h"
+
+#include "QDaqFilterPlugin.h"
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+#include <QtPlugin>
+
+#include "relaytuner.h"
+
+/**
+ * @brief A bank of PID controllers for multi-zone processes.
+ *
+ * Input i is the process value of zone i and output i its control power.
+ * Each zone runs the same algorithm as QDaqPid (isa_pid), with its own
+ * parameters given as vectors with one element per zone. Setting a vector
+ * with a single element applies the value to all zones.
+ *
+ * The controller states are stored in arrays and all zones are updated
+ * in one pass that the compiler vectorizes. Cycles with a parameter or mode
+ * change take a scalar pass that performs the bumpless switch of each zone.
+ *
+ * Auto-tuning is shared: setting #autoTune runs the relay autotuner on the
+ * zones listed in #tuneZones (all if empty), one zone at a time, while the
+ * other zones continue under control. The results are stored in #Kc and #Tc.
+ */
+class PIDBANKSHARED_EXPORT QDaqPidBank :
+        public QDaqJob,
+        public QDaqFilterPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID QDaqFilterPlugin_iid FILE "pidbank.json")
+    Q_INTERFACES(QDaqFilterPlugin)
+
+    /// Number of zones.
+    Q_PROPERTY(uint zones READ zones WRITE setZones)
+    Q_PROPERTY(double samplingPeriod READ samplingPeriod WRITE setSamplingPeriod)
+    Q_PROPERTY(bool autoMode READ autoMode WRITE setAutoMode)
+    Q_PROPERTY(QDaqVector setPoint READ setPoint WRITE setSetPoint)
+    /// Output power of each zone. Can be set only in manual mode.
+    Q_PROPERTY(QDaqVector power READ power WRITE setPower)
+    Q_PROPERTY(QDaqVector maxPower READ maxPower WRITE setMaxPower)
+    Q_PROPERTY(QDaqVector gain READ gain WRITE setGain)
+    Q_PROPERTY(QDaqVector Ti READ Ti WRITE setTi)
+    Q_PROPERTY(QDaqVector Td READ Td WRITE setTd)
+    Q_PROPERTY(QDaqVector Tr READ Tr WRITE setTr)
+    Q_PROPERTY(QDaqVector Nd READ Nd WRITE setNd)
+    Q_PROPERTY(QDaqVector beta READ beta WRITE setBeta)
+    Q_PROPERTY(bool autoTune READ autoTune WRITE setAutoTune)
+    /// Zones to auto-tune, in this order. Empty for all zones.
+    Q_PROPERTY(QDaqVector tuneZones READ tuneZones WRITE setTuneZones)
+    /// Zone being auto-tuned, -1 if none.
+    Q_PROPERTY(int tuningZone READ tuningZone)
+    Q_PROPERTY(double relayStep READ relayStep WRITE setRelayStep)
+    Q_PROPERTY(double relayThreshold READ relayThreshold WRITE setRelayThreshold)
+    Q_PROPERTY(int relayIterations READ relayIterations WRITE setRelayIterations)
+    Q_PROPERTY(QDaqVector Kc READ Kc)
+    Q_PROPERTY(QDaqVector Tc READ Tc)
+
+protected:
+    int n_;
+    double h_;
+    bool auto_, autotune_;
+
+    // parameters
+    QDaqVector sp_, umax_, k_, ti_, td_, tr_, nd_, b_;
+    // internal constants
+    QDaqVector a1_, a2_, b1_, b2_;
+
+    // controller states
+    QDaqVector ui_, ud_, pvp_, cvp_, cv_;
+    QVector<bool> atp_, changed_;
+    // the next cycle needs the scalar pass
+    bool needSlow_;
+
+    // auto-tuning
+    autotuner<double> tuner_;
+    QDaqVector tuneZones_;
+    QVector<int> tuneQueue_;
+    int tuneIdx_;
+    QDaqVector kc_, tc_;
+
+    int tuningZone() const
+    { return autotune_ && tuneIdx_<tuneQueue_.size() ? tuneQueue_[tuneIdx_] : -1; }
+
+    bool zoneVector(const QDaqVector& v, QDaqVector& x);
+    void assign(QDaqVector& dst, const QDaqVector& x);
+    void updatePar();
+    void resetStates();
+    void startTuning();
+    void fastPass(const double* pv);
+    void slowPass(const double* pv, int jtune);
+
+public:
+    QDaqPidBank();
+
+    // QDaqFilterPlugin interface implementation
+    virtual QString errorMsg() { return QString(); }
+    virtual bool init();
+    virtual bool operator()(const double* vin, double* vout);
+    virtual int nInputChannels() const { return n_; }
+    virtual int nOutputChannels() const { return n_; }
+
+    // getters
+    uint zones() const { return n_; }
+    double samplingPeriod() const { return h_; }
+    bool autoMode() const { return auto_; }
+    QDaqVector setPoint() const { return sp_; }
+    QDaqVector power() const { return cv_; }
+    QDaqVector maxPower() const { return umax_; }
+    QDaqVector gain() const { return k_; }
+    QDaqVector Ti() const { return ti_; }
+    QDaqVector Td() const { return td_; }
+    QDaqVector Tr() const { return tr_; }
+    QDaqVector Nd() const { return nd_; }
+    QDaqVector beta() const { return b_; }
+    bool autoTune() const { return autotune_; }
+    QDaqVector tuneZones() const { return tuneZones_; }
+    double relayStep() const { return tuner_.get_step(); }
+    double relayThreshold() const { return tuner_.get_dy(); }
+    int relayIterations() const { return tuner_.get_count(); }
+    QDaqVector Kc() const { return kc_; }
+    QDaqVector Tc() const { return tc_; }
+
+    // setters
+    void setZones(uint n);
+    void setSamplingPeriod(double v);
+    void setAutoMode(bool on);
+    void setSetPoint(const QDaqVector& v);
+    void setPower(const QDaqVector& v);
+    void setMaxPower(const QDaqVector& v);
+    void setGain(const QDaqVector& v);
+    void setTi(const QDaqVector& v);
+    void setTd(const QDaqVector& v);
+    void setTr(const QDaqVector& v);
+    void setNd(const QDaqVector& v);
+    void setBeta(const QDaqVector& v);
+    void setAutoTune(bool on);
+    void setTuneZones(const QDaqVector& v);
+    void setRelayStep(double v);
+    void setRelayThreshold(double v);
+    void setRelayIterations(int v);
+};
+
+#endif // QDAQPIDBANK_H
@@ -0,0 +1,33 @@
+#-------------------------------------------------
+#
+# Batched plant simulator plugin
+#
+#-------------------------------------------------
+
+QT       += script
+QT       -= gui
+CONFIG   += plugin
+
+INCLUDEPATH  += ../../lib/daq ../../lib/core
+
+# the per-plant loops are vectorized by the compiler
+unix: QMAKE_CXXFLAGS_RELEASE += -O3
+
+TARGET = $$qtLibraryTarget(qdaqplantsim)
+TEMPLATE = lib
+DESTDIR = ../../qdaq/plugins
+
+DEFINES += PLANTSIM_LIBRARY
+
+SOURCES += qdaqplantsim.cpp
+
+HEADERS += qdaqplantsim.h\
+        plantsim_global.h
+
+unix {
+    target.path = $$[QT_INSTALL_PLUGINS]/qdaq
+    INSTALLS += target
+}
+
+DISTFILES += \
+    plantsim.json
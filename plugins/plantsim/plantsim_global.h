@@ -0,0 +1,12 @@
+#ifndef PLANTSIM_GLOBAL_H
+#define PLANTSIM_GLOBAL_H
+
+#include <QtCore/qglobal.h>
+
+#if defined(PLANTSIM_LIBRARY)
+#  define PLANTSIMSHARED_EXPORT Q_DECL_EXPORT
+#else
+#  define PLANTSIMSHARED_EXPORT Q_DECL_IMPORT
+#endif
+
+#endif // PLANTSIM_GLOBAL_H
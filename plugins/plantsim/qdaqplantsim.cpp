@@ -0,0 +1,295 @@
+#include "qdaqplantsim.h"
+
+#include <cstring>
+
+QDaqPlantSim::QDaqPlantSim() : QDaqJob("plantsim"),
+    np_(1),
+    nx_(1),
+    nu_(1),
+    ny_(1),
+    depth_(1),
+    pos_(0),
+    sameLag_(true)
+{
+    setup();
+}
+
+// resize a matrix to sz elements per plant if it does not fit
+static void fit(QDaqVector& m, int sz, int np)
+{
+    if (m.size()!=sz && m.size()!=sz*np) m.fill(0.,sz);
+}
+
+void QDaqPlantSim::setup()
+{
+    fit(A_,nx_*nx_,np_);
+    fit(B_,nx_*nu_,np_);
+    fit(C_,ny_*nx_,np_);
+    fit(D_,ny_*nu_,np_);
+    if (delay_.size()!=1 && delay_.size()!=np_) delay_.fill(0.,1);
+
+    expand(A_,nx_*nx_,a_,nza_);
+    expand(B_,nx_*nu_,b_,nzb_);
+    expand(C_,ny_*nx_,c_,nzc_);
+    expand(D_,ny_*nu_,d_,nzd_);
+
+    // a delay of d samples reads the row written d cycles ago
+    lag_.resize(np_);
+    int dmax = 0;
+    for(int p=0; p<np_; ++p)
+    {
+        lag_[p] = (int)delay_[delay_.size()==1 ? 0 : p];
+        dmax = qMax(dmax,lag_[p]);
+    }
+    sameLag_ = true;
+    for(int p=1; p<np_; ++p) if (lag_[p]!=lag_[0]) sameLag_ = false;
+    depth_ = dmax + 1;
+
+    init();
+}
+
+bool QDaqPlantSim::init()
+{
+    x_.fill(0.,nx_*np_);
+    xn_.fill(0.,nx_*np_);
+    u_.fill(0.,nu_*np_);
+    y_.fill(0.,ny_*np_);
+    ring_.fill(0.,depth_*nu_*np_);
+    pos_ = 0;
+    return true;
+}
+
+bool QDaqPlantSim::matrix(const QDaqVector& m, int sz, const char* name)
+{
+    if (m.size()==sz || m.size()==sz*np_) return true;
+    throwScriptError(QString("%1 must have %2 or %3 elements.")
+                     .arg(name).arg(sz).arg(sz*np_));
+    return false;
+}
+
+void QDaqPlantSim::expand(const QDaqVector& m, int sz, QDaqVector& v, QVector<int>& nz)
+{
+    int np = np_;
+    bool shared = m.size()==sz;
+    v.resize(sz*np);
+    nz.clear();
+    for(int e=0; e<sz; ++e)
+    {
+        bool any = false;
+        for(int p=0; p<np; ++p)
+        {
+            double x = shared ? m[e] : m[p*sz + e];
+            v[e*np + p] = x;
+            if (x!=0.) any = true;
+        }
+        if (any) nz << e;
+    }
+}
+
+void QDaqPlantSim::multiply(const double* m, const QVector<int>& nz, int ncols,
+                            const double* x, double* y)
+{
+    // y += M x for all plants
+    int np = np_;
+    foreach(int e, nz)
+    {
+        const double* me = m + e*np;
+        const double* xj = x + (e % ncols)*np;
+        double* yi = y + (e / ncols)*np;
+        for(int p=0; p<np; ++p) yi[p] += me[p]*xj[p];
+    }
+}
+
+bool QDaqPlantSim::operator ()(const double* vin, double* vout)
+{
+    int np = np_, nu = nu_, ny = ny_, nx = nx_, row = nu*np;
+
+    // store the inputs by element and get the delayed ones
+    double* r = ring_.data();
+    double* w = r + pos_*row;
+    for(int p=0; p<np; ++p)
+        for(int k=0; k<nu; ++k) w[k*np + p] = vin[p*nu + k];
+
+    double* u = u_.data();
+    if (sameLag_)
+    {
+        int i = pos_ - lag_[0];
+        if (i<0) i += depth_;
+        std::memcpy(u, r + i*row, row*sizeof(double));
+    }
+    else
+    {
+        for(int p=0; p<np; ++p)
+        {
+            int i = pos_ - lag_[p];
+            if (i<0) i += depth_;
+            const double* rp = r + i*row + p;
+            for(int k=0; k<nu; ++k) u[k*np + p] = rp[k*np];
+        }
+    }
+    if (++pos_ == depth_) pos_ = 0;
+
+    // y = C x + D u
+    double* y = y_.data();
+    for(int i=0; i<ny*np; ++i) y[i] = 0.;
+    multiply(c_.constData(), nzc_, nx, x_.constData(), y);
+    multiply(d_.constData(), nzd_, nu, u, y);
+
+    // x = A x + B u
+    double* xn = xn_.data();
+    for(int i=0; i<nx*np; ++i) xn[i] = 0.;
+    multiply(a_.constData(), nza_, nx, x_.constData(), xn);
+    multiply(b_.constData(), nzb_, nu, u, xn);
+    x_.swap(xn_);
+
+    for(int p=0; p<np; ++p)
+        for(int i=0; i<ny; ++i) vout[p*ny + i] = y[i*np + p];
+
+    return true;
+}
+
+QDaqVector QDaqPlantSim::state() const
+{
+    QDaqVector v(nx_*np_);
+    for(int p=0; p<np_; ++p)
+        for(int i=0; i<nx_; ++i) v[p*nx_ + i] = x_[i*np_ + p];
+    return v;
+}
+
+void QDaqPlantSim::setPlants(uint n)
+{
+    if (throwIfArmed() || (int)n==np_) return;
+    if (n<1)
+    {
+        throwScriptError("There must be at least 1 plant.");
+        return;
+    }
+    np_ = n;
+    setup();
+    emit propertiesChanged();
+}
+void QDaqPlantSim::setStates(uint n)
+{
+    if (throwIfArmed() || (int)n==nx_) return;
+    nx_ = n;
+    setup();
+    emit propertiesChanged();
+}
+void QDaqPlantSim::setInputs(uint n)
+{
+    if (throwIfArmed() || (int)n==nu_) return;
+    if (n<1)
+    {
+        throwScriptError("There must be at least 1 input.");
+        return;
+    }
+    nu_ = n;
+    setup();
+    emit propertiesChanged();
+}
+void QDaqPlantSim::setOutputs(uint n)
+{
+    if (throwIfArmed() || (int)n==ny_) return;
+    if (n<1)
+    {
+        throwScriptError("There must be at least 1 output.");
+        return;
+    }
+    ny_ = n;
+    setup();
+    emit propertiesChanged();
+}
+void QDaqPlantSim::setA(const QDaqVector& v)
+{
+    if (!matrix(v,nx_*nx_,"A")) return;
+    if (stageProperty("A",QVariant::fromValue(v))) return;
+    os::auto_lock L(comm_lock);
+    A_ = v;
+    expand(A_,nx_*nx_,a_,nza_);
+    emit propertiesChanged();
+}
+void QDaqPlantSim::setB(const QDaqVector& v)
+{
+    if (!matrix(v,nx_*nu_,"B")) return;
+    if (stageProperty("B",QVariant::fromValue(v))) return;
+    os::auto_lock L(comm_lock);
+    B_ = v;
+    expand(B_,nx_*nu_,b_,nzb_);
+    emit propertiesChanged();
+}
+void QDaqPlantSim::setC(const QDaqVector& v)
+{
+    if (!matrix(v,ny_*nx_,"C")) return;
+    if (stageProperty("C",QVariant::fromValue(v))) return;
+    os::auto_lock L(comm_lock);
+    C_ = v;
+    expand(C_,ny_*nx_,c_,nzc_);
+    emit propertiesChanged();
+}
+void QDaqPlantSim::setD(const QDaqVector& v)
+{
+    if (!matrix(v,ny_*nu_,"D")) return;
+    if (stageProperty("D",QVariant::fromValue(v))) return;
+    os::auto_lock L(comm_lock);
+    D_ = v;
+    expand(D_,ny_*nu_,d_,nzd_);
+    emit propertiesChanged();
+}
+bool QDaqPlantSim::delayVector(const QDaqVector& v)
+{
+    if (v.size()!=1 && v.size()!=np_)
+    {
+        throwScriptError("Delay must have 1 element or 1 per plant.");
+        return false;
+    }
+    foreach(double d, v)
+    {
+        if (d<0 || d!=(int)d)
+        {
+            throwScriptError("Delay must be a non-negative integer.");
+            return false;
+        }
+    }
+    return true;
+}
+void QDaqPlantSim::setDelay(const QDaqVector& v)
+{
+    if (throwIfArmed() || !delayVector(v)) return;
+    delay_ = v;
+    setup();
+    emit propertiesChanged();
+}
+
+void QDaqPlantSim::fopdt(const QDaqVector& kp, const QDaqVector& tp, const QDaqVector& td)
+{
+    if (throwIfArmed() || !delayVector(td)) return;
+    int n = qMax(kp.size(),tp.size());
+    if (!(kp.size()==1 || kp.size()==np_) || !(tp.size()==1 || tp.size()==np_))
+    {
+        throwScriptError("Arguments must have 1 element or 1 per plant.");
+        return;
+    }
+    foreach(double t, tp)
+    {
+        if (!(t>0.))
+        {
+            throwScriptError("Time constant must be positive.");
+            return;
+        }
+    }
+
+    // state y[n-1]: A = C = 1 - 1/tp, B = D = kp/tp
+    QDaqVector a(n), b(n);
+    for(int p=0; p<n; ++p)
+    {
+        double k = kp[kp.size()==1 ? 0 : p], t = tp[tp.size()==1 ? 0 : p];
+        a[p] = 1. - 1./t;
+        b[p] = k/t;
+    }
+    nx_ = nu_ = ny_ = 1;
+    A_ = C_ = a;
+    B_ = D_ = b;
+    delay_ = td;
+    setup();
+    emit propertiesChanged();
+}
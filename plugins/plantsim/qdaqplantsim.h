@@ -0,0 +1,134 @@
+#ifndef QDAQPLANTSIM_H
+#define QDAQPLANTSIM_H
+
+#include "plantsim_global.h"
+
+#include "QDaqFilterPlugin.h"
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+#include <QtPlugin>
+
+/**
+ * @brief Simulation of a batch of discrete linear plants.
+ *
+ * Each of the #plants is the state-space model
+ *
+ *     y[n]   = C x[n] + D u[n-d]
+ *     x[n+1] = A x[n] + B u[n-d]
+ *
+ * with #states states, #inputs inputs, #outputs outputs and a dead time
+ * of d = #delay samples. The filter inputs are the inputs of plant 0,
+ * then those of plant 1 etc., and likewise for the outputs.
+ *
+ * The matrices are given row by row. A matrix with the size of one plant
+ * is used by all plants, otherwise it holds the matrices of all plants one
+ * after the other. The same holds for #delay, with 1 or 1 per plant values.
+ * Changing the dimensions resets matrices whose size does not fit to zero.
+ *
+ * fopdt() sets up first-order-plus-dead-time plants, as in the fopdt plugin.
+ *
+ * The states of all plants are stored element by element, so that each
+ * matrix element updates all plants in one loop that the compiler
+ * vectorizes. Matrix elements that are zero for all plants are skipped.
+ * The inputs are delayed through one ring buffer for all plants.
+ *
+ * The matrices can be changed while running. The dimensions and delays
+ * only while the filter is disarmed.
+ */
+class PLANTSIMSHARED_EXPORT QDaqPlantSim :
+        public QDaqJob,
+        public QDaqFilterPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID QDaqFilterPlugin_iid FILE "plantsim.json")
+    Q_INTERFACES(QDaqFilterPlugin)
+
+    /// Number of simulated plants.
+    Q_PROPERTY(uint plants READ plants WRITE setPlants)
+    /// Number of states of each plant.
+    Q_PROPERTY(uint states READ states WRITE setStates)
+    /// Number of inputs of each plant.
+    Q_PROPERTY(uint inputs READ inputs WRITE setInputs)
+    /// Number of outputs of each plant.
+    Q_PROPERTY(uint outputs READ outputs WRITE setOutputs)
+    Q_PROPERTY(QDaqVector A READ A WRITE setA)
+    Q_PROPERTY(QDaqVector B READ B WRITE setB)
+    Q_PROPERTY(QDaqVector C READ C WRITE setC)
+    Q_PROPERTY(QDaqVector D READ D WRITE setD)
+    /// Input dead time in samples.
+    Q_PROPERTY(QDaqVector delay READ delay WRITE setDelay)
+    /// Current states, plant by plant.
+    Q_PROPERTY(QDaqVector state READ state)
+
+protected:
+    int np_, nx_, nu_, ny_;
+
+    // matrices as set by the user
+    QDaqVector A_, B_, C_, D_, delay_;
+
+    // matrices by element: element e of plant p is at e*np_ + p
+    QDaqVector a_, b_, c_, d_;
+    // elements that are non-zero for some plant
+    QVector<int> nza_, nzb_, nzc_, nzd_;
+
+    // states and current inputs/outputs, by element as the matrices
+    QDaqVector x_, xn_, u_, y_;
+
+    // input ring buffer, each row holds the inputs of all plants
+    QDaqVector ring_;
+    QVector<int> lag_;
+    int depth_, pos_;
+    bool sameLag_;
+
+    bool matrix(const QDaqVector& m, int sz, const char* name);
+    bool delayVector(const QDaqVector& v);
+    void expand(const QDaqVector& m, int sz, QDaqVector& v, QVector<int>& nz);
+    void setup();
+    void multiply(const double* m, const QVector<int>& nz, int ncols,
+                  const double* x, double* y);
+
+public:
+    QDaqPlantSim();
+
+    // QDaqFilterPlugin interface implementation
+    virtual QString errorMsg() { return QString(); }
+    virtual bool init();
+    virtual bool operator()(const double* vin, double* vout);
+    virtual int nInputChannels() const { return np_*nu_; }
+    virtual int nOutputChannels() const { return np_*ny_; }
+
+    // getters
+    uint plants() const { return np_; }
+    uint states() const { return nx_; }
+    uint inputs() const { return nu_; }
+    uint outputs() const { return ny_; }
+    QDaqVector A() const { return A_; }
+    QDaqVector B() const { return B_; }
+    QDaqVector C() const { return C_; }
+    QDaqVector D() const { return D_; }
+    QDaqVector delay() const { return delay_; }
+    QDaqVector state() const;
+
+    // setters
+    void setPlants(uint n);
+    void setStates(uint n);
+    void setInputs(uint n);
+    void setOutputs(uint n);
+    void setA(const QDaqVector& v);
+    void setB(const QDaqVector& v);
+    void setC(const QDaqVector& v);
+    void setD(const QDaqVector& v);
+    void setDelay(const QDaqVector& v);
+
+public slots:
+    /**
+     * @brief Set up first-order-plus-dead-time plants.
+     *
+     * Each plant has 1 input and 1 output and y[n] = y[n-1] + (kp*u[n-td] - y[n-1])/tp,
+     * with the time constant tp and dead time td in samples.
+     * Each argument has 1 value for all plants or 1 per plant.
+     */
+    void fopdt(const QDaqVector& kp, const QDaqVector& tp, const QDaqVector& td);
+};
+
+#endif // QDAQPLANTSIM_H
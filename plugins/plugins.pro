@@ -8,5 +8,10 @@ SUBDIRS += \
     pid \
     interpolator \
     lincorr \
-    fopdt
+    fopdt \
+    hysteresis \
+    dspfilter \
+    spectrum \
+    pidbank \
+    plantsim
 
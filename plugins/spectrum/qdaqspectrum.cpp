@@ -0,0 +1,269 @@
+#include "qdaqspectrum.h"
+
+#include "QDaqEnumHelper.h"
+Q_SCRIPT_ENUM(WindowType, QDaqSpectrum)
+
+#include <QMutexLocker>
+
+#include <cmath>
+#include <cstring>
+
+QDaqSpectrum::QDaqSpectrum() :
+    QDaqJob("spectrum"),
+    nch_(1),
+    size_(1024),
+    averages_(8),
+    window_(Hann),
+    overlap_(0.5),
+    fs_(1.),
+    count_(0),
+    wavetable_(0),
+    workspace_(0)
+{
+    setup();
+}
+
+QDaqSpectrum::~QDaqSpectrum()
+{
+    if (wavetable_) gsl_fft_real_wavetable_free(wavetable_);
+    if (workspace_) gsl_fft_real_workspace_free(workspace_);
+}
+
+void QDaqSpectrum::registerTypes(QScriptEngine* e)
+{
+    qScriptRegisterWindowType(e);
+    QDaqJob::registerTypes(e);
+}
+
+void QDaqSpectrum::setup()
+{
+    int N = size_, nb = bins(), n = nch_;
+
+    // FFT tables
+    if (wavetable_) gsl_fft_real_wavetable_free(wavetable_);
+    if (workspace_) gsl_fft_real_workspace_free(workspace_);
+    wavetable_ = gsl_fft_real_wavetable_alloc(N);
+    workspace_ = gsl_fft_real_workspace_alloc(N);
+
+    // window and density scale
+    win_.resize(N);
+    double s2 = 0.;
+    for(int i=0; i<N; ++i)
+    {
+        double x = 2.*M_PI*i/N, w;
+        switch (window_)
+        {
+        case Hann: w = 0.5 - 0.5*cos(x); break;
+        case Hamming: w = 0.54 - 0.46*cos(x); break;
+        case Blackman: w = 0.42 - 0.5*cos(x) + 0.08*cos(2*x); break;
+        case FlatTop:
+            w = 0.21557895 - 0.41663158*cos(x) + 0.277263158*cos(2*x)
+                    - 0.083578947*cos(3*x) + 0.006947368*cos(4*x);
+            break;
+        default: w = 1.; break;
+        }
+        win_[i] = w;
+        s2 += w*w;
+    }
+    scale_ = 1./(fs_*s2);
+    hop_ = (uint)floor(N*(1. - overlap_) + 0.5);
+    if (hop_<1) hop_ = 1;
+
+    ring_.resize(2*N*n);
+    work_.resize(N);
+    acc_.resize(nb*n);
+    peak_.resize(n);
+
+    freq_ = QDaqBuffer(nb);
+    for(int k=0; k<nb; ++k) freq_.push(k*fs_/N);
+
+    {
+        QMutexLocker L(&backMtx_);
+        back_.fill(0., nb*n);
+        spectra_.resize(n);
+        for(int c=0; c<n; ++c) spectra_[c] = QDaqBuffer(nb);
+    }
+
+    init();
+}
+
+bool QDaqSpectrum::init()
+{
+    ring_.fill(0.);
+    acc_.fill(0.);
+    peak_.fill(0.);
+    pos_ = filled_ = sinceFrame_ = nframes_ = 0;
+    count_ = 0;
+    return true;
+}
+
+bool QDaqSpectrum::operator ()(const double* vin, double* vout)
+{
+    int N = size_, n = nch_;
+    double* r = ring_.data();
+    for(int c=0; c<n; ++c, r+=2*N) r[pos_] = r[pos_+N] = vin[c];
+    if (++pos_ == (uint)N) pos_ = 0;
+    if (filled_ < (uint)N) filled_++;
+    sinceFrame_++;
+
+    if (filled_==(uint)N && sinceFrame_>=hop_)
+    {
+        sinceFrame_ = 0;
+        frame();
+    }
+
+    std::memcpy(vout, peak_.constData(), n*sizeof(double));
+    return true;
+}
+
+void QDaqSpectrum::frame()
+{
+    int N = size_, nb = bins(), n = nch_;
+    double* w = work_.data();
+    const double* win = win_.constData();
+
+    for(int c=0; c<n; ++c)
+    {
+        // the last N samples, oldest first
+        const double* x = ring_.constData() + 2*N*c + pos_;
+        for(int i=0; i<N; ++i) w[i] = x[i]*win[i];
+        gsl_fft_real_transform(w, 1, N, wavetable_, workspace_);
+
+        // half-complex: re0, (re1,im1), (re2,im2), ... [re(N/2) if N even]
+        double* a = acc_.data() + c*nb;
+        a[0] += w[0]*w[0];
+        for(int k=1; 2*k<N; ++k) a[k] += 2.*(w[2*k-1]*w[2*k-1] + w[2*k]*w[2*k]);
+        if (!(N & 1)) a[N/2] += w[N-1]*w[N-1];
+    }
+
+    if (++nframes_ < averages_) return;
+
+    double s = scale_/nframes_;
+    {
+        QMutexLocker L(&backMtx_);
+        double* b = back_.data();
+        double* a = acc_.data();
+        for(int i=0; i<n*nb; ++i) { b[i] = a[i]*s; a[i] = 0.; }
+
+        // peak frequency, excluding DC
+        for(int c=0; c<n; ++c, b+=nb)
+        {
+            int kmax = 1;
+            for(int k=2; k<nb; ++k) if (b[k]>b[kmax]) kmax = k;
+            double d = 0.;
+            if (kmax<nb-1 && b[kmax-1]>0. && b[kmax+1]>0.)
+            {
+                // parabola through the log power of the 3 bins
+                double l0 = log(b[kmax-1]), l1 = log(b[kmax]), l2 = log(b[kmax+1]);
+                double den = l0 - 2.*l1 + l2;
+                if (den!=0.) d = 0.5*(l0 - l2)/den;
+            }
+            peak_[c] = (kmax + d)*fs_/N;
+        }
+    }
+    nframes_ = 0;
+    count_++;
+
+    // one pending request at a time; the main thread takes the latest spectra
+    if (pending_.testAndSetOrdered(0,1))
+        QMetaObject::invokeMethod(this, "publish", Qt::QueuedConnection);
+}
+
+void QDaqSpectrum::publish()
+{
+    pending_.storeRelease(0);
+    {
+        QMutexLocker L(&backMtx_);
+        int nb = back_.size()/qMax(spectra_.size(),1);
+        const double* b = back_.constData();
+        for(int c=0; c<spectra_.size(); ++c, b+=nb)
+        {
+            spectra_[c].clear();
+            spectra_[c].push(b,nb);
+        }
+    }
+    emit spectrumReady();
+}
+
+QDaqBuffer QDaqSpectrum::spectrum(int i) const
+{
+    if (i<0 || i>=spectra_.size())
+    {
+        throwScriptError("Invalid channel index.");
+        return QDaqBuffer();
+    }
+    return spectra_[i];
+}
+
+void QDaqSpectrum::setChannels(uint n)
+{
+    if (throwIfArmed() || n==nch_) return;
+    if (n<1)
+    {
+        throwScriptError("There must be at least 1 channel.");
+        return;
+    }
+    nch_ = n;
+    setup();
+    emit propertiesChanged();
+}
+
+void QDaqSpectrum::setSize(uint n)
+{
+    if (throwIfArmed() || n==size_) return;
+    if (n<4)
+    {
+        throwScriptError("Frame size must be at least 4.");
+        return;
+    }
+    size_ = n;
+    setup();
+    emit propertiesChanged();
+}
+
+void QDaqSpectrum::setWindow(WindowType w)
+{
+    if (throwIfArmed() || w==window_ || (int)w==-1) return;
+    window_ = w;
+    setup();
+    emit propertiesChanged();
+}
+
+void QDaqSpectrum::setOverlap(double v)
+{
+    if (throwIfArmed() || v==overlap_) return;
+    if (!(v>=0. && v<1.))
+    {
+        throwScriptError("Overlap must be in [0,1).");
+        return;
+    }
+    overlap_ = v;
+    setup();
+    emit propertiesChanged();
+}
+
+void QDaqSpectrum::setAverages(uint n)
+{
+    if (throwIfArmed() || n==averages_) return;
+    if (n<1)
+    {
+        throwScriptError("At least 1 frame must be averaged.");
+        return;
+    }
+    averages_ = n;
+    init();
+    emit propertiesChanged();
+}
+
+void QDaqSpectrum::setSamplingRate(double v)
+{
+    if (throwIfArmed() || v==fs_) return;
+    if (!(v>0.))
+    {
+        throwScriptError("Sampling rate must be positive.");
+        return;
+    }
+    fs_ = v;
+    setup();
+    emit propertiesChanged();
+}
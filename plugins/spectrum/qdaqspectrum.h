@@ -0,0 +1,147 @@
+#ifndef QDAQSPECTRUM_H
+#define QDAQSPECTRUM_H
+
+#include "spectrum_global.h"
+
+#include "QDaqFilterPlugin.h"
+#include "QDaqJob.h"
+#include "QDaqTypes.h"
+#include <QtPlugin>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include <gsl/gsl_fft_real.h>
+
+/**
+ * @brief Power spectrum estimation of streaming data by the Welch method.
+ *
+ * Each of the #channels inputs is collected in a frame of #size samples.
+ * Every size*(1-#overlap) samples the last frame is multiplied by the #window,
+ * Fourier transformed and its power is accumulated. After #averages frames
+ * the one-sided power spectral density (units^2/Hz) is published and a new
+ * average starts.
+ *
+ * Output i is the frequency of the spectral peak of input i (excluding DC),
+ * refined by parabolic interpolation of the log power. It holds the value
+ * of the last published spectrum.
+ *
+ * The published spectra are QDaqBuffer objects returned by spectrum(), with the
+ * corresponding frequencies in frequencies(). They are updated in the
+ * main thread, after the spectrumReady() signal, so they can be plotted directly.
+ *
+ * The FFT tables and all buffers are allocated when the properties are set,
+ * which is only possible while the filter is disarmed. Nothing is allocated
+ * while running.
+ */
+class SPECTRUMSHARED_EXPORT QDaqSpectrum :
+        public QDaqJob,
+        public QDaqFilterPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID QDaqFilterPlugin_iid FILE "spectrum.json")
+    Q_INTERFACES(QDaqFilterPlugin)
+
+    /// Number of analyzed channels.
+    Q_PROPERTY(uint channels READ channels WRITE setChannels)
+    /// Number of samples in a frame (FFT length).
+    Q_PROPERTY(uint size READ size WRITE setSize)
+    /// Window function applied to each frame.
+    Q_PROPERTY(WindowType window READ window WRITE setWindow)
+    /// Fraction of a frame overlapping with the previous one, 0 <= overlap < 1.
+    Q_PROPERTY(double overlap READ overlap WRITE setOverlap)
+    /// Number of frames averaged in each published spectrum.
+    Q_PROPERTY(uint averages READ averages WRITE setAverages)
+    /// Sampling rate in Hz, used for the frequency axis and the density.
+    Q_PROPERTY(double samplingRate READ samplingRate WRITE setSamplingRate)
+    /// Number of spectra published since the filter was armed.
+    Q_PROPERTY(uint count READ count)
+    Q_ENUMS(WindowType)
+
+public:
+    enum WindowType {
+        Rectangular,
+        Hann,
+        Hamming,
+        Blackman,
+        FlatTop
+    };
+
+protected:
+    uint nch_, size_, averages_;
+    WindowType window_;
+    double overlap_, fs_;
+    uint count_;
+
+    // FFT tables
+    gsl_fft_real_wavetable* wavetable_;
+    gsl_fft_real_workspace* workspace_;
+
+    // frames: each sample is stored twice so that the last size_
+    // samples of a channel are contiguous
+    QDaqVector ring_;
+    uint pos_, filled_, hop_, sinceFrame_, nframes_;
+    QDaqVector win_, work_;
+    double scale_;
+
+    // accumulated power, nch_ rows of bins()
+    QDaqVector acc_;
+    QDaqVector peak_;
+
+    // spectra waiting to be published
+    QMutex backMtx_;
+    QDaqVector back_;
+    QAtomicInt pending_;
+
+    // published data
+    QVector<QDaqBuffer> spectra_;
+    QDaqBuffer freq_;
+
+    int bins() const { return size_/2 + 1; }
+    void setup();
+    void frame();
+
+public:
+    QDaqSpectrum();
+    virtual ~QDaqSpectrum();
+
+    // getters
+    uint channels() const { return nch_; }
+    uint size() const { return size_; }
+    WindowType window() const { return window_; }
+    double overlap() const { return overlap_; }
+    uint averages() const { return averages_; }
+    double samplingRate() const { return fs_; }
+    uint count() const { return count_; }
+
+    // setters
+    void setChannels(uint n);
+    void setSize(uint n);
+    void setWindow(WindowType w);
+    void setOverlap(double v);
+    void setAverages(uint n);
+    void setSamplingRate(double v);
+
+    // QDaqFilterPlugin interface implementation
+    virtual QString errorMsg() { return QString(); }
+    virtual bool init();
+    virtual bool operator()(const double* vin, double* vout);
+    virtual int nInputChannels() const { return nch_; }
+    virtual int nOutputChannels() const { return nch_; }
+
+    virtual void registerTypes(QScriptEngine* e);
+
+signals:
+    /// Emitted in the main thread when new spectra have been published.
+    void spectrumReady();
+
+private slots:
+    void publish();
+
+public slots:
+    /// The last published power spectral density of input i.
+    QDaqBuffer spectrum(int i) const;
+    /// The frequencies of the spectrum bins, 0 to samplingRate/2.
+    QDaqBuffer frequencies() const { return freq_; }
+};
+
+#endif // QDAQSPECTRUM_H
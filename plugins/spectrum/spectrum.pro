@@ -0,0 +1,31 @@
+#-------------------------------------------------
+#
+# Spectral analysis plugin
+#
+#-------------------------------------------------
+
+QT       += script
+QT       -= gui
+CONFIG   += plugin
+
+INCLUDEPATH  += ../../lib/daq ../../lib/core
+LIBS += -lgsl
+
+TARGET = $$qtLibraryTarget(qdaqspectrum)
+TEMPLATE = lib
+DESTDIR = ../../qdaq/plugins
+
+DEFINES += SPECTRUM_LIBRARY
+
+SOURCES += qdaqspectrum.cpp
+
+HEADERS += qdaqspectrum.h\
+        spectrum_global.h
+
+unix {
+    target.path = $$[QT_INSTALL_PLUGINS]/qdaq
+    INSTALLS += target
+}
+
+DISTFILES += \
+    spectrum.json
@@ -0,0 +1,33 @@
+// Benchmark fused evaluation of job scripts
+//
+// A loop with 50 small script jobs, run with a separate evaluation
+// per job and with fuseScripts. Compare the load-time.
+
+var loop = new QDaqLoop("bench");
+loop.period = 10;
+var acc = new QDaqChannel("acc");
+loop.appendChild(acc);
+for (var i = 0; i < 50; i++) {
+    var job = new QDaqJob("job" + i);
+    job.code = "qdaq.bench.acc.push(" + i + ");";
+    loop.appendChild(job);
+}
+qdaq.appendChild(loop);
+
+print("Separate");
+loop.arm();
+wait(3000);
+print(loop.stat());
+loop.disarm();
+
+print("Fused");
+loop.fuseScripts = true;
+loop.arm();
+wait(3000);
+print(loop.stat());
+
+// an error is reported by the failing job
+loop.job7.code = "undefinedFunction();";
+wait(500);
+print("armed = " + loop.armed);
+loop.disarm();
@@ -0,0 +1,37 @@
+// Benchmark loop execution overhead for a large job tree
+//
+// Builds a loop with 100 groups of 100 channels (10k jobs in total)
+// and prints the loop statistics. Compare the load-time of the flat
+// execution plan with the recursive execution of the job tree.
+
+function buildTree(loop) {
+    for (var i = 0; i < 100; i++) {
+        var grp = new QDaqJob("grp" + i);
+        for (var j = 0; j < 100; j++) {
+            var ch = new QDaqChannel("ch" + j);
+            // Inc channels change every cycle, the Normal ones
+            // get no data and their computation is skipped
+            ch.type = (j % 2) ? "Inc" : "Normal";
+            grp.appendChild(ch);
+        }
+        loop.appendChild(grp);
+    }
+}
+
+var loop = new QDaqLoop("bench");
+loop.period = 50;
+buildTree(loop);
+qdaq.appendChild(loop);
+
+print("Execution plan");
+loop.arm();
+wait(5000);
+print(loop.stat());
+loop.disarm();
+
+print("Recursive");
+loop.execPlan = false;
+loop.arm();
+wait(5000);
+print(loop.stat());
+loop.disarm();
@@ -0,0 +1,44 @@
+// Test automatic phase assignment of child loops
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+qdaq.appendChild(loop);
+
+// slow child loops with 2 channels each
+var delays = [2, 4, 4, 8, 8, 8, 8];
+var sub = [];
+for (var i = 0; i < delays.length; i++) {
+    var l = new QDaqLoop("sub" + i);
+    l.delay = delays[i];
+    for (var k = 0; k < 2; k++) {
+        var ch = new QDaqChannel("ch" + k);
+        ch.type = "Random";
+        l.appendChild(ch);
+    }
+    loop.appendChild(l);
+    sub.push(l);
+}
+
+function report(title) {
+    print(title + ": worst-case cycle load = " + loop.cycleLoad);
+    for (var i = 0; i < sub.length; i++)
+        print("  " + sub[i].objectName + ": delay = " + sub[i].delay + ", phase = " + sub[i].phase);
+}
+
+// all in phase
+loop.arm();
+for (var i = 0; i < sub.length; i++) sub[i].arm();
+wait(500);
+report("preload");
+
+// balanced
+loop.autoPhase = true;
+wait(500);
+report("autoPhase");
+
+// phases are re-assigned when a child loop is removed
+sub[0].disarm();
+wait(500);
+report("sub0 disarmed");
+
+loop.disarm();
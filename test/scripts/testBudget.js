@@ -0,0 +1,37 @@
+// Test job budgets and overrun containment
+//
+// A script job blocks for 50 ms every 20 cycles, as a device waiting
+// for its timeout would. With a 5 ms budget it is skipped for 10 cycles
+// after each overrun, so the channel keeps its 10 ms rate.
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var ch = new QDaqChannel("ch");
+ch.type = "Inc";
+var dev = new QDaqJob("dev");
+dev.code = "if (qdaq.loop.count % 20 == 0) { var t0 = Date.now(); while (Date.now() - t0 < 50) {} }";
+loop.appendChild(ch);
+loop.appendChild(dev);
+qdaq.appendChild(loop);
+
+dev.budget = 5;
+
+var actions = ["LogOnly", "SkipJob", "DisarmJob"];
+for (var i = 0; i < actions.length; i++) {
+    loop.budgetAction = actions[i];
+    loop.arm();
+    wait(3000);
+    print(actions[i] + ": " + loop.count + " cycles, " + dev.budgetOverruns +
+          " overruns by " + loop.overrunJob + ", dev armed = " + dev.armed);
+    print(loop.stat());
+    loop.disarm();
+}
+
+// a cycle budget names the slowest job
+dev.budget = 0;
+loop.budget = 20;
+loop.budgetAction = "LogOnly";
+loop.arm();
+wait(3000);
+print("Cycle budget: " + loop.budgetOverruns + " overruns, last by " + loop.overrunJob);
+loop.disarm();
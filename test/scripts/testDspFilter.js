@@ -0,0 +1,45 @@
+// Test the FIR/IIR filter plugin
+//
+// 64 noisy sine channels are low-pass filtered by one dspfilter,
+// first with a 4th order Butterworth IIR, then with a 129-tap
+// windowed-sinc FIR, which is computed by FFT convolution.
+
+var N = 64;
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var gen = new QDaqJob("gen");
+gen.code = "var c = qdaq.loop.count; for (var i = 0; i < 64; i++) qdaq.loop['x' + i].push(Math.sin(0.05 * c + i) + Math.random() - 0.5);";
+loop.appendChild(gen);
+var xs = [], ys = [];
+for (var i = 0; i < N; i++) {
+    var x = new QDaqChannel("x" + i);
+    loop.appendChild(x);
+    xs.push(x);
+}
+var lp = new QDaqFilter("lp");
+lp.loadPlugin("libqdaqdspfilter.so");
+lp.dspfilter.channels = N;
+lp.inputChannels = xs;
+loop.appendChild(lp);
+for (var i = 0; i < N; i++) {
+    var y = new QDaqChannel("y" + i);
+    loop.appendChild(y);
+    ys.push(y);
+}
+lp.outputChannels = ys;
+qdaq.appendChild(loop);
+
+lp.dspfilter.butterworth(4, "LowPass", 0.05);
+print("IIR sections: " + lp.dspfilter.sos);
+loop.createLoopEngine();
+loop.arm();
+wait(2000);
+loop.disarm();
+print("IIR: x0 = " + xs[0].value() + ", y0 = " + ys[0].value());
+
+lp.dspfilter.windowedSinc(129, "LowPass", 0.05);
+print("FIR: " + lp.dspfilter.fir.length + " taps, latency " + lp.dspfilter.latency);
+loop.arm();
+wait(2000);
+loop.disarm();
+print("FIR: x0 = " + xs[0].value() + ", y0 = " + ys[0].value());
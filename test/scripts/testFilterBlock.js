@@ -0,0 +1,46 @@
+// Test block processing of filters
+//
+// A script job pushes 10 samples per cycle to channel x. The fopdt
+// filter in block mode processes all of them at each cycle.
+// Then the recorded input is processed offline from a data buffer.
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var x = new QDaqChannel("x");
+x.depth = 64;
+var gen = new QDaqJob("gen");
+gen.code = "var c = qdaq.loop.count; for (var k = 0; k < 10; k++) qdaq.loop.x.push(Math.sin(0.01 * (10 * c + k)));";
+var y = new QDaqChannel("y");
+y.depth = 64;
+var sys = new QDaqFilter("sys");
+sys.loadPlugin("libqdaqfopdt.so");
+sys.inputChannels = [x];
+sys.outputChannels = [y];
+sys.blockMode = true;
+var rec = new QDaqDataBuffer("rec");
+rec.capacity = 100000;
+rec.type = "Open";
+rec.channels = [x];
+loop.appendChild(gen);
+loop.appendChild(x);
+loop.appendChild(sys);
+loop.appendChild(y);
+qdaq.appendChild(loop);
+qdaq.appendChild(rec);
+
+loop.createLoopEngine();
+loop.arm();
+wait(2000);
+loop.disarm();
+print("Online: " + loop.count + " cycles, " + 10 * loop.count + " samples, y = " + y.value());
+
+// offline: a recorded input of 1e6 samples
+for (var i = 0; i < 1000000; i++) rec.push([Math.sin(0.01 * i)]);
+var out = new QDaqDataBuffer("out");
+out.type = "Open";
+out.channels = [y];
+qdaq.appendChild(out);
+
+var t0 = Date.now();
+sys.processBuffer(rec, out);
+print("Offline: " + out.size + " samples in " + (Date.now() - t0) + " ms");
@@ -0,0 +1,33 @@
+// Test skipping a filter channel whose input does not change
+//
+// x gets 1 and later 3, pushed after arming (arming clears the channels).
+// By default the filter channel f pushes x every cycle, so its running
+// average over 10 cycles ends at 3. With skipUnchanged only the updates
+// of x are pushed, and the average includes the 1 (and a 0 pushed once
+// before x was ready), so it stays below 3.
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var x = new QDaqChannel("x");
+var f = new QDaqFilterChannel("f");
+f.inputChannel = x;
+f.averaging = "Running";
+f.depth = 10;
+loop.appendChild(x);
+loop.appendChild(f);
+qdaq.appendChild(loop);
+loop.createLoopEngine();
+
+function check(title) {
+    loop.arm();
+    x.push(1.);
+    wait(500);
+    x.push(3.);
+    wait(500);
+    loop.disarm();
+    print(title + ": f = " + f.value() + ", skipRatio = " + loop.skipRatio);
+}
+
+check("Push every cycle (f = 3)");
+f.skipUnchanged = true;
+check("skipUnchanged (f < 3)");
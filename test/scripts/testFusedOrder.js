@@ -0,0 +1,56 @@
+// Test that fused script jobs run in place
+//
+// cnt counts the cycles. Jobs a1, a2 push cnt and 2*cnt into the channels
+// n, m that follow them, the filter channel f copies n, and jobs b1, b2
+// check f and m against cnt of the same cycle, pushing 1 into bad on
+// a mismatch. With fuseScripts a1, a2 and b1, b2 become two programs,
+// which must still run at their places, so bad stays 0 as with
+// a separate evaluation per job.
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var cnt = new QDaqChannel("cnt");
+cnt.type = "Inc";
+var a1 = new QDaqJob("a1");
+a1.code = "qdaq.loop.n.push(qdaq.loop.cnt.value());";
+var a2 = new QDaqJob("a2");
+a2.code = "qdaq.loop.m.push(2*qdaq.loop.cnt.value());";
+var n = new QDaqChannel("n");
+var m = new QDaqChannel("m");
+var f = new QDaqFilterChannel("f");
+f.inputChannel = n;
+var b1 = new QDaqJob("b1");
+b1.code = "qdaq.loop.bad.push(qdaq.loop.f.value() != qdaq.loop.cnt.value() ? 1 : 0);";
+var b2 = new QDaqJob("b2");
+b2.code = "qdaq.loop.bad.push(qdaq.loop.m.value() != 2*qdaq.loop.cnt.value() ? 1 : 0);";
+// mean of the last checks
+var bad = new QDaqChannel("bad");
+bad.averaging = "Running";
+bad.depth = 50;
+loop.appendChild(cnt);
+loop.appendChild(a1);
+loop.appendChild(a2);
+loop.appendChild(n);
+loop.appendChild(m);
+loop.appendChild(f);
+loop.appendChild(b1);
+loop.appendChild(b2);
+loop.appendChild(bad);
+qdaq.appendChild(loop);
+loop.createLoopEngine();
+
+function check(title) {
+    loop.arm();
+    wait(1000);
+    loop.disarm();
+    print(title + ": cnt = " + cnt.value() + ", bad = " + bad.value() +
+          (bad.value() == 0 ? " ok" : " FAILED"));
+}
+
+check("Separate");
+loop.fuseScripts = true;
+check("Fused");
+
+// a2 is taken out of the program and timed by itself
+a2.budget = 50;
+check("Fused, a2 with budget");
@@ -0,0 +1,50 @@
+// Test the uniform grid lookup of the interpolator plugin
+//
+// A calibration curve of 5000 points is applied to 16 channels
+// by one interpolator, first directly and then on a uniform grid.
+
+var N = 16;
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var gen = new QDaqJob("gen");
+gen.code = "for (var i = 0; i < 16; i++) qdaq.loop['v' + i].push(Math.random() * 50);";
+loop.appendChild(gen);
+var vs = [], ts = [];
+for (var i = 0; i < N; i++) {
+    var v = new QDaqChannel("v" + i);
+    loop.appendChild(v);
+    vs.push(v);
+}
+var cal = new QDaqFilter("cal");
+cal.loadPlugin("libqdaqinterpolator.so");
+cal.interpolator.channels = N;
+cal.inputChannels = vs;
+loop.appendChild(cal);
+for (var i = 0; i < N; i++) {
+    var t = new QDaqChannel("t" + i);
+    loop.appendChild(t);
+    ts.push(t);
+}
+cal.outputChannels = ts;
+qdaq.appendChild(loop);
+
+// a smooth nonlinear curve
+var x = [], y = [];
+for (var i = 0; i < 5000; i++) {
+    x.push(i * 0.01);
+    y.push(25 * x[i] - 0.05 * x[i] * x[i]);
+}
+cal.interpolator.setTable(x, y);
+cal.interpolator.type = "CubicSpline";
+
+loop.createLoopEngine();
+loop.arm();
+wait(1000);
+loop.disarm();
+print("Direct: v0 = " + vs[0].value() + ", t0 = " + ts[0].value());
+
+cal.interpolator.gridSize = 100000;
+loop.arm();
+wait(1000);
+loop.disarm();
+print("Grid: v0 = " + vs[0].value() + ", t0 = " + ts[0].value());
@@ -0,0 +1,33 @@
+// Test the sliding window regression of the lincorr plugin
+//
+// y drifts linearly with x plus noise. The correlator fits the last
+// 5000 samples at each cycle and outputs the residual statistics.
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var gen = new QDaqJob("gen");
+gen.code = "var x = qdaq.loop.count; qdaq.loop.x.push(x); qdaq.loop.y.push(3 + 0.01 * x + Math.random() - 0.5);";
+var x = new QDaqChannel("x");
+var y = new QDaqChannel("y");
+var names = ["a", "b", "r2", "sigma", "res"];
+var outs = [];
+for (var i = 0; i < names.length; i++) outs.push(new QDaqChannel(names[i]));
+var fit = new QDaqFilter("fit");
+fit.loadPlugin("libqdaqlincorr.so");
+fit.lincorr.size = 5000;
+fit.lincorr.statistics = true;
+fit.inputChannels = [x, y];
+fit.outputChannels = outs;
+loop.appendChild(gen);
+loop.appendChild(x);
+loop.appendChild(y);
+loop.appendChild(fit);
+for (var i = 0; i < outs.length; i++) loop.appendChild(outs[i]);
+qdaq.appendChild(loop);
+
+loop.createLoopEngine();
+loop.arm();
+wait(3000);
+loop.disarm();
+for (var i = 0; i < outs.length; i++) print(names[i] + " = " + outs[i].value());
+print("Samples in window: " + fit.lincorr.length);
@@ -0,0 +1,27 @@
+// Test loop timing statistics with a sub-millisecond period
+
+var loop = new QDaqLoop("fastLoop");
+loop.period = 0.5;
+// try real-time scheduling on core 1, errors are reported but the loop runs
+loop.realTimePriority = 50;
+loop.cpuAffinity = 1;
+
+var ch = new QDaqChannel("ch");
+ch.type = "Random";
+loop.appendChild(ch);
+
+qdaq.appendChild(loop);
+
+loop.arm();
+wait(2000);
+
+print(loop.stat());
+print("period  [p50,p99,p99.9,max] (ms) = " + loop.periodStats);
+print("latency [p50,p99,p99.9,max] (ms) = " + loop.latencyStats);
+print("load    [p50,p99,p99.9,max] (ms) = " + loop.loadStats);
+
+loop.resetStats();
+wait(1000);
+print("after reset, period = " + loop.periodStats);
+
+loop.disarm();
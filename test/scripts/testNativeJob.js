@@ -0,0 +1,45 @@
+// Test a native job plugin
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+
+var x = new QDaqChannel("x");
+x.type = "Random";
+x.multiplier = 10;
+var y = new QDaqChannel("y");
+
+var job = new QDaqNativeJob("cmp");
+print("Job plugins: " + job.listPlugins());
+job.loadPlugin("libqdaqhysteresis.so");
+job.inputChannels = [x];
+job.outputChannels = [y];
+job.hysteresis.low = 2;
+job.hysteresis.high = 8;
+
+loop.appendChild(x);
+loop.appendChild(job);
+loop.appendChild(y);
+qdaq.appendChild(loop);
+
+// a second comparator, added while running
+var x2 = new QDaqChannel("x2");
+x2.type = "Random";
+x2.multiplier = 10;
+var y2 = new QDaqChannel("y2");
+loop.appendChild(x2);
+loop.appendChild(y2);
+
+loop.profiling = true;
+loop.arm();
+wait(1000);
+// the number of channels can change only with both lists together
+try { job.inputChannels = [x, x2]; }
+catch (e) { print("Rejected: " + e); }
+job.setChannels([x, x2], [y, y2]);
+wait(1000);
+loop.disarm();
+print("y2 = " + y2.value());
+
+// y changes only when x crosses the thresholds
+print("count = " + loop.count + ", y = " + y.value());
+print(loop.profileReport());
@@ -0,0 +1,30 @@
+// Test missed timer periods and overrun policies
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+
+// a job that sometimes takes longer than the period
+var slow = new QDaqJob("slow");
+slow.code = "if (qdaq.loop.count % 10 == 0) { var t = new Date().getTime(); while (new Date().getTime() - t < 25); }";
+loop.appendChild(slow);
+
+qdaq.appendChild(loop);
+
+var policies = ["Skip", "CatchUp"];
+for (var i = 0; i < policies.length; i++) {
+    loop.overrunPolicy = policies[i];
+    loop.arm();
+    wait(2000);
+    loop.disarm();
+    print(policies[i] + ": count = " + loop.count + ", missed = " + loop.missedWakeups +
+          ", overruns = " + loop.overruns);
+}
+
+// the loop stops at the first overrun
+loop.overrunPolicy = "Abort";
+loop.arm();
+wait(2000);
+print("Abort: armed = " + loop.armed + ", count = " + loop.count);
+loop.disarm();
+
+print(loop.stat());
@@ -0,0 +1,40 @@
+// Test parallel execution of independent sub-jobs
+
+// create a loop
+var loop = new QDaqLoop("loop");
+loop.period = 100;
+loop.parallel = true;
+loop.threads = 3;
+
+// independent groups: random channel -> derived channel
+for (var i = 0; i < 4; i++) {
+    var grp = new QDaqJob("grp" + i);
+    var ch = new QDaqChannel("ch");
+    ch.type = "Random";
+    var f = new QDaqChannel("f");
+    f.parserExpression = "2*qdaq.loop.grp" + i + ".ch";
+    grp.appendChild(ch);
+    grp.appendChild(f);
+    loop.appendChild(grp);
+}
+
+// s reads channels of all groups, it runs after them
+var s = new QDaqChannel("s");
+s.parserExpression = "qdaq.loop.grp0.f + qdaq.loop.grp1.f + qdaq.loop.grp2.f + qdaq.loop.grp3.f";
+loop.appendChild(s);
+
+// a script job runs alone on the loop thread
+var scr = new QDaqJob("scr");
+scr.code = "qdaq.loop.s.value();";
+loop.appendChild(scr);
+
+qdaq.appendChild(loop);
+
+print("Tree = \n" + qdaq.objectTree());
+
+loop.arm();
+wait(2000);
+
+print("s = " + s.value());
+print(loop.stat());
+loop.disarm();
@@ -0,0 +1,62 @@
+// Test muParser expressions referencing other channels
+
+// create a loop
+var loop = new QDaqLoop("loop");
+loop.period = 200;
+// two random input channels
+var a = new QDaqChannel("a");
+a.type = "Random";
+var b = new QDaqChannel("b");
+b.type = "Random";
+// derived channels
+// d is placed before its inputs, it will be executed after them
+var d = new QDaqChannel("d");
+d.parserExpression = "qdaq.loop.c - qdaq.loop.a";
+var c = new QDaqChannel("c");
+c.parserExpression = "qdaq.loop.a + qdaq.loop.b";
+
+loop.appendChild(d);
+loop.appendChild(a);
+loop.appendChild(c);
+loop.appendChild(b);
+qdaq.appendChild(loop);
+
+print("Tree = \n" + qdaq.objectTree());
+
+loop.limit = 10;
+loop.arm();
+wait(3000);
+
+// d should be equal to b
+print("b = " + b.value() + ", d = " + d.value());
+
+// change expressions while running
+loop.limit = 0;
+loop.arm();
+// a cycle is rejected and the old expression is kept
+try { c.parserExpression = "qdaq.loop.d + 1"; }
+catch (e) { print("Rejected: " + e); }
+print("c = " + c.parserExpression);
+// d now uses b, which is moved before d
+d.parserExpression = "2 * qdaq.loop.b";
+wait(1000);
+loop.disarm();
+print("b = " + b.value() + ", d = " + d.value() + " (2b)");
+
+// circular references are not allowed
+b.type = "Normal";
+b.parserExpression = "qdaq.loop.d";
+print("arm with circular reference: " + loop.arm());
+print(loop.errorBacktrace());
+
+// without new data x keeps the last pushed value, the result does not drift
+b.parserExpression = "";
+var e = new QDaqChannel("e");
+e.parserExpression = "x + qdaq.loop.a";
+e.multiplier = 2;
+loop.appendChild(e);
+loop.arm();
+e.push(1.);
+wait(1000);
+loop.disarm();
+print("e = " + e.value() + ", 2*(1 + a) = " + 2*(1 + a.value()));
@@ -0,0 +1,65 @@
+// Test the pidbank plugin
+//
+// 8 first-order plants with different gains and time constants are
+// controlled by one bank of PID controllers. Zones 0 and 1 are
+// auto-tuned first, one after the other, while the rest stay in control.
+
+var nz = 8;
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var pv = [], cv = [];
+for (var i = 0; i < nz; i++) {
+    pv.push(new QDaqChannel("y" + i));
+    cv.push(new QDaqChannel("u" + i));
+}
+var pid = new QDaqFilter("pid");
+pid.loadPlugin("libqdaqpidbank.so");
+pid.pidbank.zones = nz;
+pid.pidbank.samplingPeriod = 0.01;
+pid.pidbank.maxPower = [10];
+pid.pidbank.gain = [2];
+pid.pidbank.Ti = [5];
+pid.pidbank.Td = [0];
+pid.pidbank.setPoint = [1, 2, 3, 4, 5, 6, 7, 8];
+pid.inputChannels = pv;
+pid.outputChannels = cv;
+
+var sys = [];
+for (var i = 0; i < nz; i++) {
+    var s = new QDaqFilter("sys" + i);
+    s.loadPlugin("libqdaqfopdt.so");
+    s.fopdt.kp = 1 + 0.1 * i;
+    s.fopdt.tp = 50 + 10 * i;
+    s.fopdt.td = 5;
+    s.inputChannels = [cv[i]];
+    s.outputChannels = [pv[i]];
+    sys.push(s);
+}
+
+for (var i = 0; i < nz; i++) loop.appendChild(cv[i]);
+for (var i = 0; i < nz; i++) loop.appendChild(sys[i]);
+for (var i = 0; i < nz; i++) loop.appendChild(pv[i]);
+loop.appendChild(pid);
+qdaq.appendChild(loop);
+
+loop.createLoopEngine();
+loop.arm();
+// arming resets the controllers to manual mode
+pid.pidbank.autoMode = true;
+wait(5000);
+
+pid.pidbank.relayStep = 2;
+pid.pidbank.relayThreshold = 0.05;
+pid.pidbank.tuneZones = [0, 1];
+pid.pidbank.autoTune = true;
+while (pid.pidbank.autoTune) {
+    print("Tuning zone " + pid.pidbank.tuningZone);
+    wait(1000);
+}
+print("Kc = " + pid.pidbank.Kc);
+print("Tc = " + pid.pidbank.Tc);
+
+wait(5000);
+loop.disarm();
+for (var i = 0; i < nz; i++)
+    print("zone " + i + ": y = " + pv[i].value() + " u = " + cv[i].value());
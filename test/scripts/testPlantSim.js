@@ -0,0 +1,76 @@
+// Test the plantsim plugin
+//
+// 16 first-order-plus-dead-time plants with different time constants
+// are controlled by a pidbank. A second plantsim filter simulates
+// 4 damped oscillators in state-space form, driven by a unit step.
+
+var nz = 16;
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var pv = [], cv = [];
+for (var i = 0; i < nz; i++) {
+    pv.push(new QDaqChannel("y" + i));
+    cv.push(new QDaqChannel("u" + i));
+}
+
+var sys = new QDaqFilter("sys");
+sys.loadPlugin("libqdaqplantsim.so");
+sys.plantsim.plants = nz;
+var tp = [];
+for (var i = 0; i < nz; i++) tp.push(20 + 5 * i);
+sys.plantsim.fopdt([1.5], tp, [5]);
+sys.inputChannels = cv;
+sys.outputChannels = pv;
+
+var pid = new QDaqFilter("pid");
+pid.loadPlugin("libqdaqpidbank.so");
+pid.pidbank.zones = nz;
+pid.pidbank.samplingPeriod = 0.01;
+pid.pidbank.maxPower = [10];
+pid.pidbank.gain = [1];
+pid.pidbank.Ti = [0.5];
+pid.pidbank.setPoint = [5];
+pid.inputChannels = pv;
+pid.outputChannels = cv;
+
+// x1' = x2, x2' = -w^2 x1 - 2 z w x2 + u, discretized with h = 0.1
+// and a different damping for each oscillator, y = x1
+var step = new QDaqChannel("step");
+var osc = new QDaqFilter("osc");
+osc.loadPlugin("libqdaqplantsim.so");
+osc.plantsim.plants = 4;
+osc.plantsim.states = 2;
+var A = [];
+for (var i = 0; i < 4; i++) {
+    var z = 0.1 * (i + 1), h = 0.1;
+    A.push(1, h, -h, 1 - 2 * z * h);
+}
+osc.plantsim.A = A;
+osc.plantsim.B = [0, 0.1];
+osc.plantsim.C = [1, 0];
+var ys = [];
+for (var i = 0; i < 4; i++) ys.push(new QDaqChannel("osc" + i));
+osc.inputChannels = [step, step, step, step];
+osc.outputChannels = ys;
+
+for (var i = 0; i < nz; i++) loop.appendChild(cv[i]);
+loop.appendChild(sys);
+for (var i = 0; i < nz; i++) loop.appendChild(pv[i]);
+loop.appendChild(pid);
+loop.appendChild(step);
+loop.appendChild(osc);
+for (var i = 0; i < 4; i++) loop.appendChild(ys[i]);
+qdaq.appendChild(loop);
+
+loop.createLoopEngine();
+loop.arm();
+// arming clears the channels and resets the pid bank to manual mode
+step.push(1.);
+pid.pidbank.autoMode = true;
+wait(10000);
+loop.disarm();
+
+for (var i = 0; i < nz; i++)
+    print("zone " + i + ": y = " + pv[i].value() + " u = " + cv[i].value());
+for (var i = 0; i < 4; i++) print("osc" + i + " = " + ys[i].value());
+print("Oscillator states = " + osc.plantsim.state);
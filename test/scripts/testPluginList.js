@@ -0,0 +1,24 @@
+// Test plugin discovery
+//
+// Listing reads only the plugin metadata, from the cache when the files
+// have not changed, so the second listing should be much faster.
+// A library is loaded only by loadPlugin().
+
+var f = new QDaqFilter("f");
+var t0 = new Date();
+var L = f.listPlugins();
+var t1 = new Date();
+print("Filter plugins: " + L);
+print("First listing: " + (t1 - t0) + " ms");
+
+t0 = new Date();
+L = f.listPlugins();
+t1 = new Date();
+print("Second listing: " + (t1 - t0) + " ms");
+
+var job = new QDaqNativeJob("job");
+print("Job plugins: " + job.listPlugins());
+
+// a job plugin is not a filter plugin
+print("Load hysteresis as filter: " + f.loadPlugin("libqdaqhysteresis.so"));
+print("Load lincorr as filter: " + f.loadPlugin("libqdaqlincorr.so"));
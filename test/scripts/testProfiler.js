@@ -0,0 +1,39 @@
+// Test the job profiler
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+
+// a few channels and a slow script job
+for (var i = 0; i < 3; i++) {
+    var grp = new QDaqJob("grp" + i);
+    var ch = new QDaqChannel("ch");
+    ch.type = "Random";
+    grp.appendChild(ch);
+    loop.appendChild(grp);
+}
+var slow = new QDaqJob("slow");
+slow.code = "var s = 0; for (var k = 0; k < 10000; k++) s += Math.sqrt(k);";
+loop.grp1.appendChild(slow);
+
+var sub = new QDaqLoop("sub");
+sub.delay = 5;
+var ch2 = new QDaqChannel("ch2");
+ch2.type = "Clock";
+sub.appendChild(ch2);
+loop.appendChild(sub);
+
+qdaq.appendChild(loop);
+
+loop.profiling = true;
+loop.arm();
+sub.arm();
+wait(2000);
+
+print(loop.profileReport());
+
+loop.resetProfile();
+wait(500);
+print(loop.profileReport());
+
+loop.profiling = false;
+loop.disarm();
@@ -0,0 +1,40 @@
+// Test changes of a running loop without disarming it
+
+var loop = new QDaqLoop("loop");
+loop.period = 10;
+var a = new QDaqChannel("a");
+a.type = "Inc";
+var b = new QDaqChannel("b");
+b.type = "Random";
+var job = new QDaqJob("job");
+job.code = "var x = 1;";
+var sub = new QDaqLoop("sub");
+sub.delay = 2;
+var buff = new QDaqDataBuffer("buff");
+buff.channels = [a];
+loop.appendChild(a);
+loop.appendChild(b);
+loop.appendChild(job);
+loop.appendChild(sub);
+loop.appendChild(buff);
+qdaq.appendChild(loop);
+
+loop.arm();
+sub.arm();
+wait(500);
+
+loop.period = 5;
+wait(500);
+job.code = "var x = 2;";
+wait(500);
+sub.delay = 4;
+wait(500);
+buff.channels = [a, b];
+wait(500);
+loop.period = 20;
+wait(500);
+
+print("armed = " + loop.armed + ", period = " + loop.period + " ms, count = " + loop.count);
+print("reconfigurations = " + loop.reconfigurations + ", longest gap = " + loop.reconfigGap + " ms");
+print(loop.stat());
+loop.disarm();
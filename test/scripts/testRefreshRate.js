@@ -0,0 +1,28 @@
+// Test coalesced GUI notifications
+//
+// A 1 kHz loop updates a channel at each cycle; updateWidgets()
+// reaches the GUI thread only once per frame.
+
+var loop = new QDaqLoop("loop");
+loop.period = 1;
+var ch = new QDaqChannel("ch");
+ch.type = "Inc";
+loop.appendChild(ch);
+qdaq.appendChild(loop);
+
+var n = 0;
+function onUpdate() { n++; }
+ch.updateWidgets.connect(onUpdate);
+
+var rates = [30, 10];
+for (var i = 0; i < rates.length; i++) {
+    qdaq.refreshRate = rates[i];
+    n = 0;
+    loop.arm();
+    wait(2000);
+    loop.disarm();
+    print("refreshRate = " + rates[i] + " Hz: " + loop.count + " cycles, " + n + " updates");
+}
+
+ch.updateWidgets.disconnect(onUpdate);
+qdaq.refreshRate = 30;
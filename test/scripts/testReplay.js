@@ -0,0 +1,46 @@
+// Test virtual-time loops and replay of recorded data
+
+// 1. record 1000 samples of a random channel on a virtual clock,
+//    as fast as possible
+var rec = new QDaqLoop("rec");
+rec.period = 100;
+rec.virtualClock = true;
+rec.startTime = 1.5e9;
+rec.limit = 1000;
+var t = new QDaqChannel("t");
+t.type = "Clock";
+var x = new QDaqChannel("x");
+x.type = "Random";
+var buff = new QDaqDataBuffer("buff");
+buff.capacity = 1000;
+buff.channels = [t, x];
+rec.appendChild(t);
+rec.appendChild(x);
+rec.appendChild(buff);
+qdaq.appendChild(rec);
+
+rec.arm();
+wait(1000);
+print("recorded " + buff.size + " rows, loop time = " + rec.time);
+h5write(buff, "replay.h5");
+
+// 2. replay the file at 100x speed through a channel with a parser expression
+var play = new QDaqLoop("play");
+play.period = 100;
+play.virtualClock = true;
+play.speed = 100;
+var player = new QDaqDataPlayer("player");
+player.source = h5read("replay.h5");
+var t2 = new QDaqChannel("t2");
+var x2 = new QDaqChannel("x2");
+x2.parserExpression = "2*x";
+player.channels = [t2, x2];
+play.appendChild(player);
+play.appendChild(t2);
+play.appendChild(x2);
+qdaq.appendChild(play);
+
+play.arm();
+wait(2000);
+print("replayed " + player.position + " rows, last t = " + t2.value() + ", 2x = " + x2.value());
+print(play.stat());
@@ -0,0 +1,24 @@
+// Test many slow loops on the shared timer
+
+var N = 40;
+var loops = [];
+for (var i = 0; i < N; i++) {
+    var loop = new QDaqLoop("loop" + i);
+    loop.period = 20 + 5 * (i % 8);
+    loop.sharedTimer = true;
+    var ch = new QDaqChannel("ch");
+    ch.type = "Clock";
+    loop.appendChild(ch);
+    qdaq.appendChild(loop);
+    loops.push(loop);
+}
+
+for (var i = 0; i < N; i++) loops[i].arm();
+wait(2000);
+for (var i = 0; i < N; i++) loops[i].disarm();
+
+// each loop should have run about 2000/period times
+for (var i = 0; i < N; i += 8)
+    print(loops[i].objectName + ": period = " + loops[i].period + " ms, count = " + loops[i].count);
+
+print(loops[0].stat());
@@ -0,0 +1,49 @@
+// Test the spectrum plugin
+//
+// Two vibration channels sampled at 1 kHz: a 123 Hz sine in noise
+// and a 300 Hz sine. The peak frequencies are the filter outputs and
+// the published spectrum of the first channel is plotted.
+
+var loop = new QDaqLoop("loop");
+loop.period = 1;
+var gen = new QDaqJob("gen");
+gen.code = "var t = qdaq.loop.count / 1000.; qdaq.loop.a.push(2 * Math.sin(2 * Math.PI * 123 * t) + Math.random() - 0.5); qdaq.loop.b.push(0.5 * Math.cos(2 * Math.PI * 300 * t));";
+var a = new QDaqChannel("a");
+var b = new QDaqChannel("b");
+var fa = new QDaqChannel("fa");
+var fb = new QDaqChannel("fb");
+var sp = new QDaqFilter("sp");
+sp.loadPlugin("libqdaqspectrum.so");
+sp.spectrum.channels = 2;
+sp.spectrum.size = 256;
+sp.spectrum.window = "Hann";
+sp.spectrum.overlap = 0.5;
+sp.spectrum.averages = 4;
+sp.spectrum.samplingRate = 1000;
+sp.inputChannels = [a, b];
+sp.outputChannels = [fa, fb];
+loop.appendChild(gen);
+loop.appendChild(a);
+loop.appendChild(b);
+loop.appendChild(sp);
+loop.appendChild(fa);
+loop.appendChild(fb);
+qdaq.appendChild(loop);
+
+function onSpectrum() {
+    print("Spectrum " + sp.spectrum.count + ": peaks at " + fa.value() + " Hz, " + fb.value() + " Hz");
+}
+sp.spectrum.spectrumReady.connect(onSpectrum);
+
+// plot the spectrum of channel a, redrawn at each update
+var w = loadTopLevelUi('ui/plotform.ui','spectrumForm');
+var plot1 = w.findChild("plot1");
+plot1.plot(sp.spectrum.frequencies(), sp.spectrum.spectrum(0));
+sp.spectrum.spectrumReady.connect(plot1.replot);
+w.show();
+
+loop.createLoopEngine();
+loop.arm();
+wait(3000);
+loop.disarm();
+print("Peaks: " + fa.value() + " Hz, " + fb.value() + " Hz");
@@ -21,6 +21,30 @@ DISTFILES += \
     scripts/testWidgets.js \
     scripts/testDynamicProperties.js \
     scripts/testPID.js \
+    scripts/testParser.js \
+    scripts/testParallel.js \
+    scripts/benchJobTree.js \
+    scripts/testLoopStats.js \
+    scripts/testProfiler.js \
+    scripts/testOverrun.js \
+    scripts/testReplay.js \
+    scripts/testSharedTimer.js \
+    scripts/testAutoPhase.js \
+    scripts/testNativeJob.js \
+    scripts/benchFusedScripts.js \
+    scripts/testRefreshRate.js \
+    scripts/testReconfigure.js \
+    scripts/testBudget.js \
+    scripts/testFilterBlock.js \
+    scripts/testDspFilter.js \
+    scripts/testSpectrum.js \
+    scripts/testInterpolatorGrid.js \
+    scripts/testLinCorr.js \
+    scripts/testPidBank.js \
+    scripts/testPlantSim.js \
+    scripts/testPluginList.js \
+    scripts/testFilterChannelSkip.js \
+    scripts/testFusedOrder.js \
     scripts/tbl.dat
 
 FORMS += \